@@ -0,0 +1,118 @@
+// Detection of CPU cache sizes, used to tune algorithms to the cache hierarchy of the machine they run on
+// Linux: sysconf, falling back to /sys/devices/system/cpu/cpu0/cache. Windows: GetLogicalProcessorInformation.
+
+#ifndef _CacheInfo_h
+#define _CacheInfo_h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ParallelAlgorithms
+{
+	const size_t DefaultCacheSizeL1Data = 32 * 1024;		// used when detection fails
+	const size_t DefaultCacheSizeL2     = 256 * 1024;
+
+#if !defined(_WIN32)
+	// Reads the size of a cache level/type (e.g. 1 and "Data", or 2 and "Unified") from /sys/devices/system/cpu/cpu0/cache/index*. Returns 0 when not found.
+	inline size_t _CacheSizeFromSysfs(unsigned level, const char* type)
+	{
+		for (unsigned index = 0; index < 8; index++)
+		{
+			char path[128], buffer[32];
+			unsigned cacheLevel = 0;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/level", index);
+			FILE* file = fopen(path, "r");
+			if (file == NULL)
+				break;
+			if (fscanf(file, "%u", &cacheLevel) != 1)
+				cacheLevel = 0;
+			fclose(file);
+			if (cacheLevel != level)
+				continue;
+
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/type", index);
+			file = fopen(path, "r");
+			if (file == NULL)
+				continue;
+			bool typeMatches = fscanf(file, "%31s", buffer) == 1 && (strcmp(buffer, type) == 0 || strcmp(buffer, "Unified") == 0);
+			fclose(file);
+			if (!typeMatches)
+				continue;
+
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/size", index);
+			file = fopen(path, "r");
+			if (file == NULL)
+				continue;
+			size_t size = 0;
+			if (fscanf(file, "%31s", buffer) == 1)		// e.g. "48K" or "2048K" or "1M"
+			{
+				char* suffix;
+				size = strtoul(buffer, &suffix, 10);
+				if (*suffix == 'K')      size *= 1024;
+				else if (*suffix == 'M') size *= 1024 * 1024;
+			}
+			fclose(file);
+			return size;
+		}
+		return 0;
+	}
+#endif
+
+	// Size of a cache level in bytes, for the data cache of level 1 and the unified cache of level 2. Returns 0 when not detected.
+	inline size_t _DetectCacheSize(unsigned level)
+	{
+		size_t size = 0;
+#if defined(_WIN32)
+		DWORD bufferSize = 0;
+		GetLogicalProcessorInformation(NULL, &bufferSize);
+		SYSTEM_LOGICAL_PROCESSOR_INFORMATION* info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)malloc(bufferSize);
+		if (info != NULL && GetLogicalProcessorInformation(info, &bufferSize))
+		{
+			for (size_t i = 0; i < bufferSize / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION); i++)
+				if (info[i].Relationship == RelationCache && info[i].Cache.Level == level &&
+				   (info[i].Cache.Type == CacheData || info[i].Cache.Type == CacheUnified))
+				{
+					size = info[i].Cache.Size;
+					break;
+				}
+		}
+		free(info);
+#else
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+		long sysconfSize = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : _SC_LEVEL2_CACHE_SIZE);
+		if (sysconfSize > 0)
+			size = (size_t)sysconfSize;
+#endif
+		if (size == 0)
+			size = _CacheSizeFromSysfs(level, "Data");
+#endif
+		return size;
+	}
+
+	// Per-core L1 data cache size in bytes, detected once
+	inline size_t CacheSizeL1Data()
+	{
+		static const size_t size = _DetectCacheSize(1);
+		return size != 0 ? size : DefaultCacheSizeL1Data;
+	}
+
+	// Per-core (or per core cluster) L2 cache size in bytes, detected once
+	inline size_t CacheSizeL2()
+	{
+		static const size_t size = _DetectCacheSize(2);
+		return size != 0 ? size : DefaultCacheSizeL2;
+	}
+}
+
+#endif
@@ -6,6 +6,7 @@
 #define _CountingSort_h
 
 //#include <cstddef>
+#include "LargePageAllocator.h"
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
 #include <thread>
@@ -164,9 +165,9 @@ namespace ParallelAlgorithms
 		std::cout << "Counting Sort algorithm" << std::endl;
 
 		size_t COUNT_ARRAY_SIZE = (size_t)1 << (sizeof(unsigned int) * 8);  // tied to the type of the input array - i.e. index of the count array is the array element value
-		unsigned SIZE_OF_EACH_COUNT = sizeof(unsigned);  // 32-bits for arrays smaller than 4 billion elements
-		unsigned* counts_p;
-		counts_p = new unsigned[COUNT_ARRAY_SIZE * SIZE_OF_EACH_COUNT]();
+		unsigned* counts_p;		// 32-bit counts for arrays smaller than 4 billion elements
+		counts_p = allocate_working_buffer< unsigned >(COUNT_ARRAY_SIZE);	// large pages reduce TLB misses of the random count increments
+		std::fill_n(counts_p, COUNT_ARRAY_SIZE, 0);	// zero out the counts array
 
 		for (size_t _current = l; _current < r; _current++)	    // Scan the array and count the number of times each value appears
 			counts_p[array_to_sort[_current]]++;
@@ -189,7 +190,7 @@ namespace ParallelAlgorithms
 #endif
 			start_index += counts_p[count_index];
 		}
-		delete[] counts_p;
+		free_working_buffer(counts_p, COUNT_ARRAY_SIZE);
 		//const auto endTime = high_resolution_clock::now();
 		//print_results("Fill inside byte array Counting Sort", startTime, endTime);
 	}
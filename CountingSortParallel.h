@@ -13,15 +13,19 @@
 #include <iostream>
 #include <algorithm>
 #include <chrono>
+#include <numeric>
 #include <random>
 #include <ratio>
 #include <vector>
 #include <thread>
 #include <execution>
+#include <atomic>
 
+#include "InsertionSort.h"
 #include "RadixSortMsdParallel.h"
 #include "FillParallel.h"
 #include "HistogramParallel.h"
+#include "LargePageAllocator.h"
 
 namespace ParallelAlgorithms
 {
@@ -31,8 +35,8 @@ namespace ParallelAlgorithms
     {
 		//const auto startTimeHistogram = high_resolution_clock::now();
 
-		size_t* counts = HistogramOneByteComponentParallel_3< NumberOfBins >(array_to_sort, l, r, threshold_count);
-		//size_t* counts = HistogramOneByteComponentParallel< NumberOfBins >(array_to_sort, l, r, threshold_count);
+		size_t* counts = HistogramOneByteComponentParallel< NumberOfBins >(array_to_sort, l, r, threshold_count);	// allocates only the returned counts
+		//size_t* counts = HistogramOneByteComponentParallel_3< NumberOfBins >(array_to_sort, l, r, threshold_count);
 
 		//const auto endTimeHistogram = high_resolution_clock::now();
 		//print_results_par("Parallel Histogram inside byte array Counting Sort", startTimeHistogram, endTimeHistogram);
@@ -88,5 +92,132 @@ namespace ParallelAlgorithms
         counting_sort_parallel_inner< NumberOfBins >(a, 0, a_size, threshold_count, threshold_fill);
 		//counting_sort_parallel_inner< PowerOfTwoRadix >(a, 0, a_size);
 	}
+
+	// Larger ranges of values are sorted by Radix Sort, as their histogram of 32-bit counts no longer fits in half of the L2 cache of a core
+	// (the same budget as the privatized histogram_par)
+	inline size_t CountingSortMaximumNumberOfValues()
+	{
+		return CacheSizeL2() / 2 / sizeof(uint32_t);
+	}
+
+	// Number of work quantas of the parallel Counting Sort, each of which counts into its own privatized histogram of numberOfValues 32-bit counts.
+	// One per thread of the task arena, limited so that all of the histograms together take no more than half of the memory of the array, since zeroing,
+	// combining and scanning them would otherwise take longer than counting. Returns 0 when even a single histogram does not fit.
+	inline size_t _CountingSortNumberOfQuantas(size_t a_size, size_t sizeOfKey, size_t numberOfValues, size_t threshold_count = 64 * 1024)
+	{
+		size_t numberOfQuantas = (std::min)(_MaxConcurrency(), (a_size + threshold_count - 1) / threshold_count);
+		numberOfQuantas = (std::min)(numberOfQuantas, a_size * sizeOfKey / 2 / (numberOfValues * sizeof(uint32_t)));
+		if (numberOfQuantas == 0)
+			return 0;
+		return (std::max)(numberOfQuantas, (a_size + UINT32_MAX - 1) / UINT32_MAX);		// 32-bit counts of each work quanta
+	}
+
+	// Counting Sort of an array with values within [minValue, minValue + numberOfValues), in numberOfQuantas work quantas (see _CountingSortNumberOfQuantas)
+	// Each work quanta counts into its own privatized histogram of 32-bit counts, all of which are combined by value in parallel, followed by
+	// a parallel scan into the starting index of each value, and a parallel fill of each value.
+	// Returns false, leaving the array unchanged, when a key is outside of the range, which is found while counting, before the array is written.
+	template< class _Type >
+	inline bool counting_sort_parallel_inner(_Type* array_to_sort, size_t a_size, _Type minValue, size_t numberOfValues, size_t numberOfQuantas, size_t threshold_fill = 64 * 1024)
+	{
+		size_t workQuanta = (a_size + numberOfQuantas - 1) / numberOfQuantas;
+		std::atomic< bool > outOfRange(false);
+
+		uint32_t* counts = allocate_working_buffer< uint32_t >(numberOfQuantas * numberOfValues);	// counts[quanta][value]
+
+#if defined(USE_PPL)
+		Concurrency::parallel_for(size_t(0), numberOfQuantas, [&](size_t q)
+#else
+		tbb::parallel_for(size_t(0), numberOfQuantas, [&](size_t q)
+#endif
+		{
+			uint32_t* count = counts + q * numberOfValues;
+			std::fill(count, count + numberOfValues, 0);		// zeroed by the thread counting into it, which keeps it in its cache
+			size_t end = (std::min)(a_size, (q + 1) * workQuanta);
+			for (size_t current = q * workQuanta; current < end; current++)
+			{
+				size_t value = (size_t)(_Type)(array_to_sort[current] - minValue);
+				if (value >= numberOfValues)
+				{
+					outOfRange.store(true, std::memory_order_relaxed);
+					break;
+				}
+				count[value]++;
+			}
+		});
+		if (outOfRange.load(std::memory_order_relaxed))
+		{
+			free_working_buffer(counts, numberOfQuantas * numberOfValues);
+			return false;
+		}
+
+		size_t* totals         = allocate_working_buffer< size_t >(numberOfValues);
+		size_t* start_indexes  = allocate_working_buffer< size_t >(numberOfValues);
+
+#if defined(USE_PPL)
+		Concurrency::parallel_for(size_t(0), numberOfValues, size_t(4096), [&](size_t first)
+		{
+			size_t last = (std::min)(first + 4096, numberOfValues);
+#else
+		tbb::parallel_for(tbb::blocked_range< size_t >(0, numberOfValues, 4096), [&](const tbb::blocked_range< size_t >& range)
+		{
+			size_t first = range.begin(), last = range.end();
+#endif
+			for (size_t value = first; value < last; value++)
+				totals[value] = 0;
+			for (size_t q = 0; q < numberOfQuantas; q++)
+			{
+				uint32_t* count = counts + q * numberOfValues;
+				for (size_t value = first; value < last; value++)
+					totals[value] += count[value];
+			}
+		});
+		std::exclusive_scan(std::execution::par_unseq, totals, totals + numberOfValues, start_indexes, (size_t)0);
+
+#if defined(USE_PPL)
+		Concurrency::parallel_for(size_t(0), numberOfValues, [&](size_t value)
+#else
+		tbb::parallel_for(size_t(0), numberOfValues, [&](size_t value)
+#endif
+		{
+			parallel_fill(array_to_sort, (_Type)(minValue + value), start_indexes[value], start_indexes[value] + totals[value], threshold_fill);
+		});
+
+		free_working_buffer(start_indexes, numberOfValues);
+		free_working_buffer(totals,        numberOfValues);
+		free_working_buffer(counts,        numberOfQuantas * numberOfValues);
+		return true;
+	}
+
+	// Counting Sort of 16-bit unsigned keys, which are sorted much faster than by Radix Sort, since the array is read once and written once
+	// Small arrays are sorted by Insertion Sort, instead of zeroing, combining and scanning histograms of all 65536 values
+	inline void counting_sort_parallel(unsigned short* a, size_t a_size)
+	{
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		if (a_size < Threshold)
+		{
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+			return;
+		}
+		const size_t NumberOfValues = (size_t)1 << 16;
+		counting_sort_parallel_inner< unsigned short >(a, a_size, 0, NumberOfValues, (std::max)(_CountingSortNumberOfQuantas(a_size, sizeof(unsigned short), NumberOfValues), (size_t)1));
+	}
+
+	// Counting Sort of 32-bit unsigned keys, which are all expected within [minValue, maxValue] - e.g. small domain codes, such as status codes or categories.
+	// Ranges of more than CountingSortMaximumNumberOfValues(), or too many values for the size of the array (see _CountingSortNumberOfQuantas),
+	// are sorted in-place by the parallel MSD Radix Sort. So are arrays with any key outside of [minValue, maxValue], which is found while counting.
+	inline void counting_sort_parallel(unsigned* a, size_t a_size, unsigned minValue, unsigned maxValue)
+	{
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		if (a_size < Threshold)
+		{
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+			return;
+		}
+
+		size_t numberOfValues  = (size_t)(maxValue - minValue) + 1;
+		size_t numberOfQuantas = numberOfValues <= CountingSortMaximumNumberOfValues() ? _CountingSortNumberOfQuantas(a_size, sizeof(unsigned), numberOfValues) : 0;
+		if (numberOfQuantas == 0 || !counting_sort_parallel_inner< unsigned >(a, a_size, minValue, numberOfValues, numberOfQuantas))
+			parallel_hybrid_inplace_msd_radix_sort(a, a_size);
+	}
 }
 #endif
\ No newline at end of file
@@ -101,3 +101,63 @@ int CountingSortBenchmark(vector<unsigned>& uints)
 	return 0;
 }
 
+
+// Small-domain keys (e.g. status codes or categories): parallel Counting Sort vs. parallel std::sort and parallel in-place MSD Radix Sort
+int CountingSortParallel16Benchmark(vector<unsigned>& uints)
+{
+	vector<unsigned short> ushorts(uints.size()), ushortsCopy(uints.size());
+	vector<unsigned>       codes(   uints.size()), codesCopy(   uints.size());
+	const unsigned minCode = 1000000, numberOfCodes = 50000;
+	for (size_t j = 0; j < uints.size(); j++)
+	{
+		ushorts[j] = (unsigned short)uints[j];
+		codes[j]   = minCode + uints[j] % numberOfCodes;
+	}
+	vector<unsigned short> ushorts_reference(ushorts);
+	vector<unsigned>       codes_reference(codes);
+	sort(std::execution::par_unseq, ushorts_reference.begin(), ushorts_reference.end());
+	sort(std::execution::par_unseq, codes_reference.begin(),   codes_reference.end());
+
+	printf("\n%zu 16-bit keys\n", uints.size());
+	for (int algorithm = 0; algorithm < 2; algorithm++)
+	{
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			std::copy(ushorts.begin(), ushorts.end(), ushortsCopy.begin());
+			const auto startTime = high_resolution_clock::now();
+			if (algorithm == 0)
+				ParallelAlgorithms::counting_sort_parallel(ushortsCopy.data(), ushortsCopy.size());
+			else
+				sort(std::execution::par_unseq, ushortsCopy.begin(), ushortsCopy.end());
+			const auto endTime = high_resolution_clock::now();
+			print_results(algorithm == 0 ? "Parallel Counting Sort" : "Parallel std::sort", startTime, endTime);
+			if (ushorts_reference != ushortsCopy)
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+		}
+	}
+
+	printf("\n%zu 32-bit keys of %u values\n", uints.size(), numberOfCodes);
+	for (int algorithm = 0; algorithm < 2; algorithm++)
+	{
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			std::copy(codes.begin(), codes.end(), codesCopy.begin());
+			const auto startTime = high_resolution_clock::now();
+			if (algorithm == 0)
+				ParallelAlgorithms::counting_sort_parallel(codesCopy.data(), codesCopy.size(), minCode, minCode + numberOfCodes - 1);
+			else
+				ParallelAlgorithms::parallel_hybrid_inplace_msd_radix_sort(codesCopy.data(), codesCopy.size());
+			const auto endTime = high_resolution_clock::now();
+			print_results(algorithm == 0 ? "Parallel Counting Sort" : "Parallel In-Place MSD Radix Sort", startTime, endTime);
+			if (codes_reference != codesCopy)
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+		}
+	}
+	return 0;
+}
@@ -196,11 +196,13 @@ inline size_t* HistogramNbitComponents(unsigned inArray[], size_t l, size_t r, u
 	return count;
 }
 
+// l and r boundaries are both inclusive. Returns count[digit][NumberOfBins] of all 8 byte components of the 64-bit keys.
 template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix >
-inline size_t** HistogramByteComponents(unsigned long long inArray[], int l, int r)
+inline size_t** HistogramByteComponents(unsigned long long inArray[], size_t l, size_t r)
 {
 	const unsigned numberOfDigits = Log2ofPowerOfTwoRadix;
 	const unsigned NumberOfBins   = PowerOfTwoRadix;
+	static_assert(PowerOfTwoRadix == 256, "HistogramByteComponents: only byte components (256 bins) are supported");
 
 	size_t** count = new size_t * [numberOfDigits];
 
@@ -212,15 +214,22 @@ inline size_t** HistogramByteComponents(unsigned long long inArray[], int l, int
 	size_t* count1 = count[1];
 	size_t* count2 = count[2];
 	size_t* count3 = count[3];
+	size_t* count4 = count[4];
+	size_t* count5 = count[5];
+	size_t* count6 = count[6];
+	size_t* count7 = count[7];
 
-	for (int current = l; current <= r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
+	for (size_t current = l; current <= r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
 	{
-		unsigned long value = inArray[current];
-		count0[value         & 0xff]++;
+		unsigned long long value = inArray[current];
+		count0[ value        & 0xff]++;
 		count1[(value >>  8) & 0xff]++;
 		count2[(value >> 16) & 0xff]++;
 		count3[(value >> 24) & 0xff]++;
+		count4[(value >> 32) & 0xff]++;
+		count5[(value >> 40) & 0xff]++;
+		count6[(value >> 48) & 0xff]++;
+		count7[(value >> 56) & 0xff]++;
 	}
 	return count;
 }
-
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Configuration.h"
+#include "RadixSortCommon.h"
+#include "CacheInfo.h"
 
 #include <iostream>
 #include <algorithm>
@@ -9,29 +11,205 @@
 #include <vector>
 #include <thread>
 #include <execution>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <stdint.h>
+#include <string.h>
 
 namespace ParallelAlgorithms
 {
-	// left (l) boundary is inclusive and right (r) boundary is exclusive
-	template< unsigned NumberOfBins >
-	inline size_t* HistogramOneByteComponentParallel(unsigned char inArray[], size_t l, size_t r, size_t parallelThreshold = 64 * 1024)
+	// Multi-bucket histogram kernels: consecutive elements are counted into 4 (or 8 for bytes) interleaved sub-histograms of 32-bit counts,
+	// which are added into the result at the end. Low-entropy data (e.g. constant and presorted arrays, many repeated bytes) increments the same count
+	// over and over, and a single histogram serializes every increment on the store-to-load forwarding of the previous one. Interleaved sub-histograms
+	// break this dependency chain, and 32-bit counts keep all of them in the L1 cache. Counts are accumulated into the result count array (+=),
+	// in blocks of at most HistogramMaximumBlockSize elements, which keeps 32-bit counts from overflowing.
+	const size_t HistogramMaximumBlockSize = UINT32_MAX;
+
+	// Histogram of one digit of inArray[l .. r - 1], selected by shiftRight and masked to PowerOfTwoRadix bins, added into count
+	// Works for any unsigned integer type of array elements (e.g. 32-bit and 64-bit), with _KeyPass::key_in applied to each element
+	// Sub-histograms of digits wider than 10 bits would no longer fit in the L1 cache, and a single histogram is used for them instead.
+	template< unsigned long PowerOfTwoRadix, class _Type, class _KeyPass = RadixKeyIdentity, class _CountType >
+	inline void HistogramOneComponentMulti(const _Type* inArray, size_t l, size_t r, unsigned long shiftRight, _CountType* count)
 	{
-		size_t* countLeft  = NULL;
-		size_t* countRight = NULL;
+		const size_t NumberOfBins          = PowerOfTwoRadix;
+		const size_t NumberOfSubHistograms = 4;
+		const _Type  mask = (_Type)(PowerOfTwoRadix - 1);
+		auto digit = [=](_Type value) { return (size_t)((_KeyPass::key_in(value) >> shiftRight) & mask); };
 
-		if (l >= r)      // zero elements to compare
+		if (NumberOfBins > 1024 || r - l < NumberOfSubHistograms * NumberOfBins)	// too few elements to pay for the sub-histograms
 		{
-			countLeft = new size_t[NumberOfBins]{};
-			return countLeft;
+			for (size_t current = l; current < r; current++)
+				count[digit(inArray[current])]++;
+			return;
 		}
-		if ((r - l) <= parallelThreshold)
+		alignas(64) uint32_t subCount[NumberOfSubHistograms][NumberOfBins];
+		for (size_t blockStart = l; blockStart < r; blockStart += HistogramMaximumBlockSize)
 		{
-			countLeft = new size_t[NumberOfBins]{};
+			size_t blockEnd = (std::min)(r, blockStart + HistogramMaximumBlockSize);	// non-inclusive
+			for (size_t s = 0; s < NumberOfSubHistograms; s++)
+				for (size_t b = 0; b < NumberOfBins; b++)
+					subCount[s][b] = 0;
+
+			size_t current = blockStart;
+			size_t last_by_four = blockStart + ((blockEnd - blockStart) / 4) * 4;
+			for (; current < last_by_four; current += 4)
+			{
+				subCount[0][digit(inArray[current    ])]++;
+				subCount[1][digit(inArray[current + 1])]++;
+				subCount[2][digit(inArray[current + 2])]++;
+				subCount[3][digit(inArray[current + 3])]++;
+			}
+			for (; current < blockEnd; current++)		// possibly last few elements
+				subCount[0][digit(inArray[current])]++;
 
-			for (size_t current = l; current < r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
-				countLeft[inArray[current]]++;
+			for (size_t b = 0; b < NumberOfBins; b++)		// merge the sub-histograms
+				count[b] += (_CountType)subCount[0][b] + subCount[1][b] + subCount[2][b] + subCount[3][b];
+		}
+	}
 
-			return countLeft;
+	// Histogram of all 4 byte components of unsigned inArray[l .. r - 1], added into count0 .. count3 of 256 bins each
+	template< class _CountType >
+	inline void HistogramByteComponentsMulti(const unsigned* inArray, size_t l, size_t r, _CountType* count0, _CountType* count1, _CountType* count2, _CountType* count3)
+	{
+		const size_t NumberOfDigits        = 4;
+		const size_t NumberOfBins          = 256;
+		const size_t NumberOfSubHistograms = 4;
+
+		alignas(64) uint32_t subCount[NumberOfSubHistograms][NumberOfDigits][NumberOfBins];
+		for (size_t blockStart = l; blockStart < r; blockStart += HistogramMaximumBlockSize)
+		{
+			size_t blockEnd = (std::min)(r, blockStart + HistogramMaximumBlockSize);	// non-inclusive
+			for (size_t s = 0; s < NumberOfSubHistograms; s++)
+				for (size_t d = 0; d < NumberOfDigits; d++)
+					for (size_t b = 0; b < NumberOfBins; b++)
+						subCount[s][d][b] = 0;
+
+			auto countValue = [&](uint32_t (*countSub)[NumberOfBins], unsigned value)
+			{
+				countSub[0][ value        & 0xff]++;
+				countSub[1][(value >>  8) & 0xff]++;
+				countSub[2][(value >> 16) & 0xff]++;
+				countSub[3][(value >> 24) & 0xff]++;
+			};
+			size_t current = blockStart;
+			size_t last_by_four = blockStart + ((blockEnd - blockStart) / 4) * 4;
+			for (; current < last_by_four; current += 4)
+			{
+				countValue(subCount[0], inArray[current    ]);
+				countValue(subCount[1], inArray[current + 1]);
+				countValue(subCount[2], inArray[current + 2]);
+				countValue(subCount[3], inArray[current + 3]);
+			}
+			for (; current < blockEnd; current++)		// possibly last few elements
+				countValue(subCount[0], inArray[current]);
+
+			_CountType* count[NumberOfDigits] = { count0, count1, count2, count3 };
+			for (size_t d = 0; d < NumberOfDigits; d++)		// merge the sub-histograms
+				for (size_t b = 0; b < NumberOfBins; b++)
+					count[d][b] += (_CountType)subCount[0][d][b] + subCount[1][d][b] + subCount[2][d][b] + subCount[3][d][b];
+		}
+	}
+
+	// Histogram of byte array inArray[l .. r - 1], added into count[256]. Bytes are read 64-bits at a time, with each of the 8 bytes of a 64-bit word
+	// counted into its own sub-histogram. Bytes before the first 8-byte aligned address, and after the last one, are counted individually.
+	template< class _CountType >
+	inline void HistogramOneByteComponentMulti(const unsigned char* inArray, size_t l, size_t r, _CountType* count)
+	{
+		const size_t NumberOfBins          = 256;
+		const size_t NumberOfSubHistograms = 8;
+
+		if (r - l < NumberOfSubHistograms * NumberOfBins)	// too few elements to pay for the sub-histograms
+		{
+			for (size_t current = l; current < r; current++)
+				count[inArray[current]]++;
+			return;
+		}
+		alignas(64) uint32_t subCount[NumberOfSubHistograms][NumberOfBins];
+		for (size_t blockStart = l; blockStart < r; blockStart += HistogramMaximumBlockSize)
+		{
+			size_t blockEnd = (std::min)(r, blockStart + HistogramMaximumBlockSize);	// non-inclusive
+			for (size_t s = 0; s < NumberOfSubHistograms; s++)
+				for (size_t b = 0; b < NumberOfBins; b++)
+					subCount[s][b] = 0;
+
+			size_t current = blockStart;
+			for (; current < blockEnd && ((uintptr_t)(inArray + current) & 0x7) != 0; current++)	// unaligned head, up to the first 8-byte aligned address
+				subCount[0][inArray[current]]++;
+
+			size_t last_by_eight = current + ((blockEnd - current) / 8) * 8;
+			for (; current < last_by_eight; current += 8)
+			{
+				uint64_t eight_bytes;
+				memcpy(&eight_bytes, inArray + current, sizeof(eight_bytes));	// a single 64-bit load, without breaking strict aliasing of the byte array
+				subCount[0][ eight_bytes        & 0xff]++;
+				subCount[1][(eight_bytes >>  8) & 0xff]++;
+				subCount[2][(eight_bytes >> 16) & 0xff]++;
+				subCount[3][(eight_bytes >> 24) & 0xff]++;
+				subCount[4][(eight_bytes >> 32) & 0xff]++;
+				subCount[5][(eight_bytes >> 40) & 0xff]++;
+				subCount[6][(eight_bytes >> 48) & 0xff]++;
+				subCount[7][(eight_bytes >> 56) & 0xff]++;
+			}
+			for (; current < blockEnd; current++)		// tail of fewer than 8 bytes
+				subCount[0][inArray[current]]++;
+
+			for (size_t b = 0; b < NumberOfBins; b++)		// merge the sub-histograms
+			{
+				_CountType sum = 0;
+				for (size_t s = 0; s < NumberOfSubHistograms; s++)
+					sum += subCount[s][b];
+				count[b] += sum;
+			}
+		}
+	}
+
+	// Count table of one thread for the parallel histograms below, into which all leaves of the recursion run by that thread accumulate, instead of
+	// allocating a count array for every leaf and combining them pairwise on the way back up. Count tables of all threads are reduced once at the end.
+	template< class _CountType, size_t NumberOfCounts >
+	struct _HistogramThreadCounts
+	{
+		_CountType count[NumberOfCounts] = {};
+	};
+
+	// Number of threads the parallel tasks may run on: the limit of the current task arena or scheduler (e.g. set by tbb::global_control,
+	// or a tbb::task_arena), which may be fewer than the cores of the machine
+	inline size_t _MaxConcurrency()
+	{
+#if defined(USE_PPL)
+		unsigned int numberOfVirtualProcessors = Concurrency::CurrentScheduler::GetNumberOfVirtualProcessors();	// -1 when there is no scheduler yet
+		return (numberOfVirtualProcessors != (unsigned int)-1 && numberOfVirtualProcessors > 0) ? numberOfVirtualProcessors : Concurrency::GetProcessorCount();
+#else
+		return (size_t)tbb::this_task_arena::max_concurrency();
+#endif
+	}
+
+#if defined(USE_PPL)
+	template< class _ThreadCounts > using _HistogramThreadLocal = Concurrency::combinable< _ThreadCounts >;
+#else
+	template< class _ThreadCounts > using _HistogramThreadLocal = tbb::enumerable_thread_specific< _ThreadCounts >;
+#endif
+
+	// Adds the count tables of all threads into count[0 .. NumberOfCounts - 1]
+	template< class _CountType, size_t NumberOfCounts >
+	inline void _HistogramReduceThreadCounts(_HistogramThreadLocal< _HistogramThreadCounts< _CountType, NumberOfCounts > >& threadCounts, _CountType* count)
+	{
+		threadCounts.combine_each([count](const _HistogramThreadCounts< _CountType, NumberOfCounts >& counts)
+		{
+			for (size_t j = 0; j < NumberOfCounts; j++)
+				count[j] += counts.count[j];
+		});
+	}
+
+	// left (l) boundary is inclusive and right (r) boundary is exclusive
+	template< unsigned NumberOfBins >
+	inline void _HistogramOneByteComponentParallel(unsigned char inArray[], size_t l, size_t r, size_t parallelThreshold,
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, NumberOfBins > >& threadCounts)
+	{
+		if ((r - l) <= parallelThreshold)
+		{
+			HistogramOneByteComponentMulti(inArray, l, r, threadCounts.local().count);
+			return;
 		}
 
 		size_t m = r / 2 + l / 2 + (r % 2 + l % 2) / 2;  // average without overflow
@@ -41,16 +219,24 @@ namespace ParallelAlgorithms
 #else
 		tbb::parallel_invoke(
 #endif
-			[&] { countLeft  = HistogramOneByteComponentParallel <NumberOfBins>(inArray, l, m, parallelThreshold); },
-			[&] { countRight = HistogramOneByteComponentParallel <NumberOfBins>(inArray, m, r, parallelThreshold); }
+			[&] { _HistogramOneByteComponentParallel <NumberOfBins>(inArray, l, m, parallelThreshold, threadCounts); },
+			[&] { _HistogramOneByteComponentParallel <NumberOfBins>(inArray, m, r, parallelThreshold, threadCounts); }
 		);
-		// Combine left and right results
-		for (size_t j = 0; j < NumberOfBins; j++)
-			countLeft[j] += countRight[j];
+	}
 
-		delete[] countRight;
+	// left (l) boundary is inclusive and right (r) boundary is exclusive
+	// Returns the count array, which the caller deletes. No other memory is allocated, other than a count table per thread.
+	template< unsigned NumberOfBins >
+	inline size_t* HistogramOneByteComponentParallel(unsigned char inArray[], size_t l, size_t r, size_t parallelThreshold = 64 * 1024)
+	{
+		size_t* count = new size_t[NumberOfBins]{};
+		if (l >= r)      // zero elements to compare
+			return count;
 
-		return countLeft;
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, NumberOfBins > > threadCounts;
+		_HistogramOneByteComponentParallel< NumberOfBins >(inArray, l, r, parallelThreshold, threadCounts);
+		_HistogramReduceThreadCounts(threadCounts, count);
+		return count;
 	}
 
 	// left (l) boundary is inclusive and right (r) boundary is exclusive
@@ -68,27 +254,7 @@ namespace ParallelAlgorithms
 		if ((r - l) <= parallelThreshold)
 		{
 			countLeft = new size_t[NumberOfBins]{};
-			size_t current = l;
-			//if (((unsigned long long)(inArray + l) & 0x7) != 0)
-			//	printf("Memory alignment is not on 8-byte boundary\n");
-			// TODO: Detect not-64-bit aligned address and process bytes individually until alignment is achieved and then do 64-bits at a time
-			size_t last_by_eight = l + ((r - l) / 8) * 8;
-			unsigned long long* inArrayCurr = (unsigned long long*)(inArray + current);
-			for (; current < last_by_eight; current += 8, inArrayCurr++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
-			{
-				unsigned long long eight_bytes = *inArrayCurr;
-				countLeft[ eight_bytes        & 0xff]++;
-				countLeft[(eight_bytes >>  8) & 0xff]++;
-				countLeft[(eight_bytes >> 16) & 0xff]++;
-				countLeft[(eight_bytes >> 24) & 0xff]++;
-				countLeft[(eight_bytes >> 32) & 0xff]++;
-				countLeft[(eight_bytes >> 40) & 0xff]++;
-				countLeft[(eight_bytes >> 48) & 0xff]++;
-				countLeft[(eight_bytes >> 56) & 0xff]++;
-			}
-			for (; current < r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
-				countLeft[inArray[current]]++;
-
+			HistogramOneByteComponentMulti(inArray, l, r, countLeft);		// handles the unaligned head and tail, with 64-bit reads in between
 			return countLeft;
 		}
 
@@ -246,64 +412,18 @@ namespace ParallelAlgorithms
 		return countLeft_0;
 	}
 
-	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix >
-	inline size_t** HistogramByteComponentsParallel(unsigned inArray[], size_t l, size_t r, size_t parallelThreshold = 64 * 1024)
+	// l and r boundaries are both inclusive
+	template< unsigned PowerOfTwoRadix >
+	inline void _HistogramByteComponentsParallel(unsigned inArray[], size_t l, size_t r, size_t parallelThreshold,
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, 4 * PowerOfTwoRadix > >& threadCounts)
 	{
-		const unsigned numberOfDigits = Log2ofPowerOfTwoRadix;
-		const unsigned NumberOfBins   = PowerOfTwoRadix;
-
-		size_t** countLeft  = NULL;
-		size_t** countRight = NULL;
-
-		if (l > r)      // zero elements to compare
-		{
-			countLeft = new size_t* [numberOfDigits];
+		const unsigned NumberOfBins = PowerOfTwoRadix;
 
-			for (unsigned i = 0; i < numberOfDigits; i++)
-			{
-				countLeft[i] = new size_t[NumberOfBins];
-				for (unsigned j = 0; j < NumberOfBins; j++)
-					countLeft[i][j] = 0;
-			}
-			return countLeft;
-		}
 		if ((r - l + 1) <= parallelThreshold)
 		{
-			countLeft = new size_t* [numberOfDigits];
-
-			for (unsigned i = 0; i < numberOfDigits; i++)
-			{
-				countLeft[i] = new size_t[NumberOfBins];
-				for (unsigned j = 0; j < NumberOfBins; j++)
-					countLeft[i][j] = 0;
-			}
-			// Faster version, since it doesn't use a 2-D array, reducing one level of indirection
-			size_t* count0 = countLeft[0];
-			size_t* count1 = countLeft[1];
-			size_t* count2 = countLeft[2];
-			size_t* count3 = countLeft[3];
-#if 1
-			for (size_t current = l; current <= r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
-			{
-				unsigned value = inArray[current];
-				count0[value         & 0xff]++;
-				count1[(value >>  8) & 0xff]++;
-				count2[(value >> 16) & 0xff]++;
-				count3[(value >> 24) & 0xff]++;
-			}
-#else
-			// Seems to be about the same performance as masking and shifting
-			for (int current = l; current <= r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
-			{
-				either value;
-				value.dw = inArray[current];
-				count0[value.bytes.b[0]]++;
-				count1[value.bytes.b[1]]++;
-				count2[value.bytes.b[2]]++;
-				count3[value.bytes.b[3]]++;
-			}
-#endif
-			return countLeft;
+			size_t* count = threadCounts.local().count;
+			HistogramByteComponentsMulti(inArray, l, r + 1, count, count + NumberOfBins, count + 2 * NumberOfBins, count + 3 * NumberOfBins);
+			return;
 		}
 
 		size_t m = r / 2 + l / 2 + (r % 2 + l % 2) / 2;   // average without overflow
@@ -313,154 +433,120 @@ namespace ParallelAlgorithms
 #else
 		tbb::parallel_invoke(
 #endif
-			[&] { countLeft  = HistogramByteComponentsParallel <PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, l,     m, parallelThreshold); },
-			[&] { countRight = HistogramByteComponentsParallel <PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, m + 1, r, parallelThreshold); }
+			[&] { _HistogramByteComponentsParallel <PowerOfTwoRadix>(inArray, l,     m, parallelThreshold, threadCounts); },
+			[&] { _HistogramByteComponentsParallel <PowerOfTwoRadix>(inArray, m + 1, r, parallelThreshold, threadCounts); }
 		);
-		// Combine left and right results
-		for (unsigned i = 0; i < numberOfDigits; i++)
-			for (unsigned j = 0; j < NumberOfBins; j++)
-				countLeft[i][j] += countRight[i][j];
-
-		for (unsigned i = 0; i < numberOfDigits; i++)
-			delete[] countRight[i];
-		delete[] countRight;
-
-		return countLeft;
 	}
 
-	// Returns count[quanta][NumberOfBins]
+	// l and r boundaries are both inclusive. Returns count[digit][NumberOfBins] of the 4 byte components, which the caller deletes.
+	// No other memory is allocated, other than a count table per thread.
 	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix >
-	inline size_t** HistogramByteComponentsAcrossWorkQuantasQC(unsigned inArray[], size_t l, size_t r, size_t workQuanta, size_t numberOfQuantas, unsigned whichByte)
+	inline size_t** HistogramByteComponentsParallel(unsigned inArray[], size_t l, size_t r, size_t parallelThreshold = 64 * 1024)
 	{
-		const unsigned NumberOfBins = PowerOfTwoRadix;
-		const unsigned mask = 0xff;
-		int shiftRightAmount = (int)(8 * whichByte);
-		//cout << "HistogramQC: l = " << l << "  r = " << r << "  workQuanta = " << workQuanta << "  quanta = " << quanta << "  whichByte = " << whichByte << endl;
-
-		size_t** count = new size_t * [numberOfQuantas];
-		for (size_t i = 0; i < numberOfQuantas; i++)
-		{
-			count[i] = new size_t[NumberOfBins];
-			for (unsigned long j = 0; j < NumberOfBins; j++)
-				count[i][j] = 0;
-		}
+		const unsigned numberOfDigits = Log2ofPowerOfTwoRadix;
+		const unsigned NumberOfBins   = PowerOfTwoRadix;
+		static_assert(PowerOfTwoRadix == 256, "HistogramByteComponentsParallel: only byte components (256 bins) are supported");
 
-		if (l > r)
+		size_t** count = new size_t* [numberOfDigits];
+		for (unsigned i = 0; i < numberOfDigits; i++)
+			count[i] = new size_t[NumberOfBins]{};
+		if (l > r)      // zero elements to compare
 			return count;
 
-		size_t startQuanta = l / workQuanta;
-		size_t endQuanta   = r / workQuanta;
-		if (startQuanta == endQuanta)       // counting within a single workQuanta, either partial or full
-		{
-			size_t q = startQuanta;
-			for (size_t currIndex = l; currIndex <= r; currIndex++)
-			{
-				unsigned inByte = (inArray[currIndex] >> shiftRightAmount) & mask;
-				count[q][inByte]++;
-			}
-		}
-		else
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, 4 * PowerOfTwoRadix > > threadCounts;
+		_HistogramByteComponentsParallel< PowerOfTwoRadix >(inArray, l, r, parallelThreshold, threadCounts);
+		threadCounts.combine_each([count](const _HistogramThreadCounts< size_t, 4 * PowerOfTwoRadix >& counts)
 		{
-			size_t currIndex, endIndex;
-
-			// process startQuanta, which is either partial or full
-			size_t q = startQuanta;
-			endIndex = startQuanta * workQuanta + (workQuanta - 1);
-			for (currIndex = l; currIndex <= endIndex; currIndex++)
-			{
-				unsigned inByte = (inArray[currIndex] >> shiftRightAmount) & mask;
-				count[q][inByte]++;
-			}
-
-			// process endQuanta, which is either partial or full
-			q = endQuanta;
-			for (currIndex = endQuanta * workQuanta; currIndex <= r; currIndex++)
-			{
-				unsigned inByte = (inArray[currIndex] >> shiftRightAmount) & mask;
-				count[q][inByte]++;
-			}
-
-			// process full workQuantas > startQuanta and < endQuanta
-			currIndex = (startQuanta + 1) * workQuanta;
-			endQuanta--;
-			for (q = startQuanta + 1; q <= endQuanta; q++)
-			{
-				for (size_t j = 0; j < workQuanta; j++)
-				{
-					unsigned inByte = (inArray[currIndex++] >> shiftRightAmount) & mask;
-					count[q][inByte]++;
-				}
-			}
-		}
-
+			for (unsigned i = 0; i < 4; i++)
+				for (unsigned j = 0; j < NumberOfBins; j++)
+					count[i][j] += counts.count[i * NumberOfBins + j];
+		});
 		return count;
 	}
 
-	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix >
-	inline size_t** HistogramByteComponentsQCParInner(unsigned inArray[], size_t l, size_t r, size_t workQuanta, size_t numberOfQuantas, unsigned whichByte, size_t parallelThreshold = 16 * 1024)
+	// Counts every digit of value into count[digit * NumberOfBins + bin], with the loop over digits unrolled at compile time
+	template< unsigned BitsPerDigit, class _Type, size_t... Digits >
+	inline void _HistogramCountDigits(_Type value, size_t* count, std::index_sequence< Digits... >)
 	{
-		const unsigned NumberOfBins = PowerOfTwoRadix;
-		size_t** countLeft  = NULL;
-		size_t** countRight = NULL;
+		const size_t NumberOfBins = (size_t)1 << BitsPerDigit;
+		const _Type  mask = (_Type)(NumberOfBins - 1);
+		((count[Digits * NumberOfBins + (size_t)((value >> (Digits * BitsPerDigit)) & mask)]++), ...);
+	}
 
-		if (l > r)      // zero elements to compare
+	// left (l) boundary is inclusive and right (r) boundary is exclusive
+	template< unsigned BitsPerDigit, class _Type >
+	inline void _HistogramDigitComponentsParallel(const _Type inArray[], size_t l, size_t r, size_t parallelThreshold,
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, ((sizeof(_Type) * 8 + BitsPerDigit - 1) / BitsPerDigit) << BitsPerDigit > >& threadCounts)
+	{
+		const size_t NumberOfDigits = (sizeof(_Type) * 8 + BitsPerDigit - 1) / BitsPerDigit;
+
+		if ((r - l) <= parallelThreshold)
 		{
-			countLeft = new size_t * [numberOfQuantas];
-			for (size_t i = 0; i < numberOfQuantas; i++)
-			{
-				countLeft[i] = new size_t[NumberOfBins];
-				for (unsigned j = 0; j < NumberOfBins; j++)
-					countLeft[i][j] = 0;
-			}
-			return countLeft;
+			size_t* count = threadCounts.local().count;
+			for (size_t current = l; current < r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
+				_HistogramCountDigits< BitsPerDigit >(inArray[current], count, std::make_index_sequence< NumberOfDigits >());
+			return;
 		}
-		if ((r - l + 1) <= parallelThreshold)
-			return HistogramByteComponentsAcrossWorkQuantasQC<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, l, r, workQuanta, numberOfQuantas, whichByte);
 
-		size_t m = ((r + l) / 2);
+		size_t m = r / 2 + l / 2 + (r % 2 + l % 2) / 2;  // average without overflow
 
 #if defined(USE_PPL)
 		Concurrency::parallel_invoke(
 #else
 		tbb::parallel_invoke(
 #endif
-			[&] { countLeft  = HistogramByteComponentsQCParInner <PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, l,     m, workQuanta, numberOfQuantas, whichByte, parallelThreshold); },
-			[&] { countRight = HistogramByteComponentsQCParInner <PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, m + 1, r, workQuanta, numberOfQuantas, whichByte, parallelThreshold); }
+			[&] { _HistogramDigitComponentsParallel <BitsPerDigit, _Type>(inArray, l, m, parallelThreshold, threadCounts); },
+			[&] { _HistogramDigitComponentsParallel <BitsPerDigit, _Type>(inArray, m, r, parallelThreshold, threadCounts); }
 		);
-		// Combine left and right results (reduce step), only for workQuantas for which the counts were computed
-		size_t startQuanta = l / workQuanta;
-		size_t endQuanta   = r / workQuanta;
-		for (size_t i = startQuanta; i <= endQuanta; i++)
-			for (unsigned long j = 0; j < NumberOfBins; j++)
-				countLeft[i][j] += countRight[i][j];
-
-		for (size_t i = 0; i < numberOfQuantas; i++)
-			delete[] countRight[i];
-		delete[] countRight;
-
-		return countLeft;
 	}
 
-	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix >
-	inline size_t** HistogramByteComponentsQCPar(unsigned* inArray, size_t l, size_t r, size_t workQuanta, size_t numberOfQuantas, unsigned whichByte, size_t parallelThreshold = 16 * 1024)
+	// One-pass histogram of all BitsPerDigit-bit digits of 32-bit and 64-bit unsigned keys: e.g. 8 digits of 8-bits, 6 digits of 11-bits (the last one of 9-bits),
+	// or 4 digits of 16-bits for 64-bit keys, and 2 digits of 16-bits for 32-bit keys. The array is read once for all digits.
+	// left (l) boundary is inclusive and right (r) boundary is exclusive, both of size_t, for arrays of any size.
+	// Returns count[digit * NumberOfBins + bin], which the caller deletes. No other memory is allocated, other than a count table per thread.
+	template< unsigned BitsPerDigit, class _Type >
+	inline size_t* HistogramDigitComponentsParallel(const _Type inArray[], size_t l, size_t r, size_t parallelThreshold = 64 * 1024)
 	{
-		//may return 0 when not able to detect
-		auto processor_count = std::thread::hardware_concurrency();
-		if (processor_count < 1)
-		{
-			processor_count = 1;
-			//cout << "Warning: Fewer than 1 processor core detected. Using only a single core.";
-		}
+		static_assert(std::is_unsigned<_Type>::value && (sizeof(_Type) == 4 || sizeof(_Type) == 8), "HistogramDigitComponentsParallel: only 32-bit and 64-bit unsigned keys are supported");
+		static_assert(BitsPerDigit >= 1 && BitsPerDigit <= 16, "HistogramDigitComponentsParallel: digits of 1 to 16 bits are supported");
+		const size_t NumberOfCounts = ((sizeof(_Type) * 8 + BitsPerDigit - 1) / BitsPerDigit) << BitsPerDigit;
+
+		size_t* count = new size_t[NumberOfCounts]{};
+		if (l >= r)      // zero elements to compare
+			return count;
 
-		size_t length = r - l + 1;
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, NumberOfCounts > > threadCounts;
+		_HistogramDigitComponentsParallel< BitsPerDigit, _Type >(inArray, l, r, parallelThreshold, threadCounts);
+		_HistogramReduceThreadCounts(threadCounts, count);
+		return count;
+	}
 
-		if ((parallelThreshold * processor_count) < length)
-			parallelThreshold = length / processor_count;
-#if 1
-		return HistogramByteComponentsQCParInner<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, l, r, workQuanta, numberOfQuantas, whichByte, parallelThreshold);
+	// Histogram of one byte/digit (whichByte) for each work quanta of inArray[0 .. size - 1], into count[quanta][NumberOfBins] - rows of a single
+	// cache-line aligned count arena (e.g. RadixSortWorkspace::count_table), which is filled in without allocating any memory.
+	// Each work quanta is counted by its own task into its own row, with no reduction of partial histograms needed.
+	// _CountType can be uint32_t for work quanta of fewer than 2^32 elements
+	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix, class _Type, class _KeyPass = RadixKeyIdentity, class _CountType >
+	inline void HistogramByteComponentsQCPar(_Type* inArray, size_t size, size_t workQuanta, size_t numberOfQuantas, unsigned whichByte, _CountType** count)
+	{
+		const size_t NumberOfBins = PowerOfTwoRadix;
+		unsigned shiftRightAmount = Log2ofPowerOfTwoRadix * whichByte;
+#if defined(USE_PPL)
+		Concurrency::task_group g;
 #else
-		return HistogramByteComponentsAcrossWorkQuantasQC<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, l, r, workQuanta, quanta, whichByte);
+		tbb::task_group g;
 #endif
+		for (size_t q = 0; q < numberOfQuantas; q++)
+		{
+			size_t startIndex = q * workQuanta;
+			size_t   endIndex = (std::min)(startIndex + workQuanta, size);	// non-inclusive, last work quanta may be partially filled
+			g.run([=] {
+				_CountType* countLoc = count[q];
+				for (size_t b = 0; b < NumberOfBins; b++)
+					countLoc[b] = 0;
+				HistogramOneComponentMulti< PowerOfTwoRadix, _Type, _KeyPass >(inArray, startIndex, endIndex, shiftRightAmount, countLoc);
+				});
+		}
+		g.wait();
 	}
 
 	// This version did not seem to speed up over the single count array version. It proves that Histogram is not the bottleneck.
@@ -532,28 +618,15 @@ namespace ParallelAlgorithms
 		return countLeft_0;
 	}
 
-	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix >
-	inline size_t* HistogramOneByteComponentParallel(unsigned inArray[], size_t l, size_t r, unsigned long shiftRight, size_t parallelThreshold = 64 * 1024)
+	// l and r boundaries are both inclusive
+	template< unsigned long PowerOfTwoRadix, class _Type, class _KeyPass >
+	inline void _HistogramOneComponentParallel(_Type inArray[], size_t l, size_t r, unsigned long shiftRight, size_t parallelThreshold,
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, PowerOfTwoRadix > >& threadCounts)
 	{
-		const size_t NumberOfBins = PowerOfTwoRadix;
-		const unsigned mask = NumberOfBins - 1;
-
-		size_t* countLeft  = NULL;
-		size_t* countRight = NULL;
-
-		if (l > r)      // zero elements to compare
-		{
-			countLeft = new size_t[NumberOfBins]{};
-			return countLeft;
-		}
 		if ((r - l + 1) <= parallelThreshold)
 		{
-			countLeft = new size_t[NumberOfBins]{};
-
-			for (size_t current = l; current <= r; current++)    // Scan the array and count the number of times each digit value appears - i.e. size of each bin
-				countLeft[(inArray[current] >> shiftRight) & mask]++;
-
-			return countLeft;
+			HistogramOneComponentMulti< PowerOfTwoRadix, _Type, _KeyPass >(inArray, l, r + 1, shiftRight, threadCounts.local().count);
+			return;
 		}
 
 		size_t m = r / 2 + l / 2 + (r % 2 + l % 2) / 2;
@@ -563,16 +636,108 @@ namespace ParallelAlgorithms
 #else
 		tbb::parallel_invoke(
 #endif
-			[&] { countLeft  = HistogramOneByteComponentParallel <PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, l, m, shiftRight, parallelThreshold); },
-			[&] { countRight = HistogramOneByteComponentParallel <PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, m + 1, r, shiftRight, parallelThreshold); }
+			[&] { _HistogramOneComponentParallel <PowerOfTwoRadix, _Type, _KeyPass>(inArray, l,     m, shiftRight, parallelThreshold, threadCounts); },
+			[&] { _HistogramOneComponentParallel <PowerOfTwoRadix, _Type, _KeyPass>(inArray, m + 1, r, shiftRight, parallelThreshold, threadCounts); }
 		);
-		// Combine left and right results
-		for (size_t j = 0; j < NumberOfBins; j++)
-			countLeft[j] += countRight[j];
+	}
 
-		delete[] countRight;
+	// Works for any unsigned integer type of array elements (e.g. 32-bit and 64-bit), with _KeyPass::key_in applied to each element
+	// l and r boundaries are both inclusive. Returns the count array, which the caller deletes. No other memory is allocated, other than a count table per thread.
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Type, class _KeyPass = RadixKeyIdentity >
+	inline size_t* HistogramOneByteComponentParallel(_Type inArray[], size_t l, size_t r, unsigned long shiftRight, size_t parallelThreshold = 64 * 1024)
+	{
+		const size_t NumberOfBins = PowerOfTwoRadix;
 
-		return countLeft;
+		size_t* count = new size_t[NumberOfBins]{};
+		if (l > r)      // zero elements to compare
+			return count;
+
+		_HistogramThreadLocal< _HistogramThreadCounts< size_t, PowerOfTwoRadix > > threadCounts;
+		_HistogramOneComponentParallel< PowerOfTwoRadix, _Type, _KeyPass >(inArray, l, r, shiftRight, parallelThreshold, threadCounts);
+		_HistogramReduceThreadCounts(threadCounts, count);
+		return count;
+	}
+
+	enum class HistogramStrategy
+	{
+		Automatic,		// Privatized when a histogram fits in half of the L2 cache, and Atomic otherwise
+		Privatized,		// each thread counts into its own histogram, and all of them are added together at the end
+		Atomic			// all threads count into a single shared histogram with atomic increments
+	};
+
+	// Histogram of num_bins bins of [first, last), with bin_fn(element) returning the bin of each element, which must be within [0, num_bins).
+	// bin_fn can be any function of the element, e.g. latency buckets of doubles, or a hash of keys into 64K to 1M bins.
+	// Privatized histograms stay in the cache of each core, and avoid atomics, but take memory and reduction time of num_bins per thread.
+	// Huge histograms no longer fit in the cache, with every increment missing it anyway, and a single shared histogram of atomic counts
+	// is used instead, where increments rarely collide, as they are spread over many bins. Returns counts of all bins.
+	template< class _RandomAccessIterator, class _BinFunction >
+	inline std::vector< size_t > histogram_par(_RandomAccessIterator first, _RandomAccessIterator last, size_t num_bins, _BinFunction bin_fn,
+		HistogramStrategy strategy = HistogramStrategy::Automatic, size_t parallelThreshold = 64 * 1024)
+	{
+		std::vector< size_t > count(num_bins);
+		size_t size = (size_t)(last - first);
+		if (size == 0 || num_bins == 0)
+			return count;
+
+		if (strategy == HistogramStrategy::Automatic)
+			strategy = (num_bins * sizeof(size_t) <= CacheSizeL2() / 2 || _MaxConcurrency() <= 1) ? HistogramStrategy::Privatized : HistogramStrategy::Atomic;
+
+		if (strategy == HistogramStrategy::Privatized)
+		{
+			_HistogramThreadLocal< std::vector< size_t > > threadCounts([num_bins] { return std::vector< size_t >(num_bins); });
+#if defined(USE_PPL)
+			Concurrency::parallel_for(size_t(0), size, parallelThreshold, [&](size_t begin)
+			{
+				size_t end = (std::min)(begin + parallelThreshold, size);
+#else
+			tbb::parallel_for(tbb::blocked_range< size_t >(0, size, parallelThreshold), [&](const tbb::blocked_range< size_t >& range)
+			{
+				size_t begin = range.begin(), end = range.end();
+#endif
+				size_t* countLoc = threadCounts.local().data();
+				for (size_t current = begin; current < end; current++)
+					countLoc[(size_t)bin_fn(first[current])]++;
+			});
+
+			// Reduce histograms of all threads in parallel, with each task adding a range of bins of all of them
+			std::vector< const size_t* > threadCountPtrs;
+			threadCounts.combine_each([&](const std::vector< size_t >& counts) { threadCountPtrs.push_back(counts.data()); });
+			const size_t BinsPerTask = 4096;
+#if defined(USE_PPL)
+			Concurrency::parallel_for(size_t(0), num_bins, BinsPerTask, [&](size_t begin)
+			{
+				size_t end = (std::min)(begin + BinsPerTask, num_bins);
+#else
+			tbb::parallel_for(tbb::blocked_range< size_t >(0, num_bins, BinsPerTask), [&](const tbb::blocked_range< size_t >& range)
+			{
+				size_t begin = range.begin(), end = range.end();
+#endif
+				for (const size_t* counts : threadCountPtrs)
+					for (size_t b = begin; b < end; b++)
+						count[b] += counts[b];
+			});
+		}
+		else
+		{
+			std::unique_ptr< std::atomic< size_t >[] > atomicCount(new std::atomic< size_t >[num_bins]);
+			for (size_t b = 0; b < num_bins; b++)
+				atomicCount[b].store(0, std::memory_order_relaxed);
+#if defined(USE_PPL)
+			Concurrency::parallel_for(size_t(0), size, parallelThreshold, [&](size_t begin)
+			{
+				size_t end = (std::min)(begin + parallelThreshold, size);
+#else
+			tbb::parallel_for(tbb::blocked_range< size_t >(0, size, parallelThreshold), [&](const tbb::blocked_range< size_t >& range)
+			{
+				size_t begin = range.begin(), end = range.end();
+#endif
+				for (size_t current = begin; current < end; current++)
+					atomicCount[(size_t)bin_fn(first[current])].fetch_add(1, std::memory_order_relaxed);
+			});
+			for (size_t b = 0; b < num_bins; b++)
+				count[b] = atomicCount[b].load(std::memory_order_relaxed);
+		}
+		return count;
 	}
 
 }
\ No newline at end of file
@@ -23,4 +23,49 @@ inline void insertionSortSimilarToSTLnoSelfAssignment( _Type* a, size_t a_size )
 	}
 }
 
+// Stable key-value Insertion Sort: sorts keys, moving values along with their keys
+template< class _KeyType, class _ValueType >
+inline void insertionSortByKey( _KeyType* keys, _ValueType* values, size_t a_size )
+{
+	for ( size_t i = 1; i < a_size; i++ )
+	{
+		if ( keys[ i ] < keys[ i - 1 ] )	// strictly less keeps equal keys in their original order (stable)
+		{
+			_KeyType   currentKey   = keys[   i ];
+			_ValueType currentValue = values[ i ];
+			keys[   i ] = keys[   i - 1 ];
+			values[ i ] = values[ i - 1 ];
+			size_t j;
+			for ( j = i - 1; j > 0 && currentKey < keys[ j - 1 ]; j-- )
+			{
+				keys[   j ] = keys[   j - 1 ];
+				values[ j ] = values[ j - 1 ];
+			}
+			keys[   j ] = currentKey;
+			values[ j ] = currentValue;
+		}
+	}
+}
+
+// Stable Insertion Sort of records, ordered by the key returned by getKey(record)
+template< class _Type, class _KeyFunction >
+inline void insertionSortByKeyFunction( _Type* a, size_t a_size, _KeyFunction getKey )
+{
+	for ( size_t i = 1; i < a_size; i++ )
+	{
+		if ( getKey( a[ i ] ) < getKey( a[ i - 1 ] ) )	// strictly less keeps equal keys in their original order (stable)
+		{
+			_Type currentElement = a[ i ];
+			auto  currentKey     = getKey( currentElement );
+			a[ i ] = a[ i - 1 ];
+			size_t j;
+			for ( j = i - 1; j > 0 && currentKey < getKey( a[ j - 1 ] ); j-- )
+			{
+				a[ j ] = a[ j - 1 ];
+			}
+			a[ j ] = currentElement;
+		}
+	}
+}
+
 #endif
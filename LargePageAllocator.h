@@ -0,0 +1,184 @@
+// Allocation of large working buffers backed by large OS pages (2 MB on x86-64 instead of 4 KB), which reduce TLB misses of algorithms
+// with random memory accesses, such as permutations of Radix Sort and Counting Sort, and merges of large arrays.
+// Linux: mmap with madvise(MADV_HUGEPAGE) for transparent huge pages, or MAP_HUGETLB for explicit huge pages reserved in the hugetlbfs pool.
+// Windows: VirtualAlloc with MEM_LARGE_PAGES, which needs the "Lock pages in memory" privilege.
+// Falls back to smaller pages, and then to operator new, whenever large pages are not available.
+
+#ifndef _LargePageAllocator_h
+#define _LargePageAllocator_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <new>
+#include <type_traits>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace ParallelAlgorithms
+{
+	enum class LargePageMode
+	{
+		Off,			// regular (4 KB) pages from operator new
+		Transparent,	// Linux transparent huge pages, requested with madvise(MADV_HUGEPAGE). Regular pages on Windows
+		Explicit		// huge pages reserved by the administrator (Linux hugetlbfs pool, Windows large pages), falling back to Transparent
+	};
+
+	const size_t LargePageSize         = 2 * 1024 * 1024;
+	const size_t LargePageMinimumBytes = 2 * LargePageSize;		// smaller buffers use operator new, as most of a large page would be wasted
+
+	inline std::atomic< LargePageMode >& _LargePageModeSetting()
+	{
+		static std::atomic< LargePageMode > mode{ LargePageMode::Transparent };
+		return mode;
+	}
+
+	// Large page mode of all working buffers allocated after this call (Transparent by default)
+	inline void          large_page_mode(LargePageMode mode) { _LargePageModeSetting() = mode; }
+	inline LargePageMode large_page_mode()                   { return _LargePageModeSetting(); }
+
+	// Kept right after the end of each buffer (at the cache line boundary), to free it the same way it was allocated
+	struct _LargePageBufferTrailer
+	{
+		enum Kind { OperatorNew, MemoryMap, VirtualAllocation };
+		void*  base;
+		size_t mappedBytes;
+		Kind   kind;
+	};
+
+	inline size_t _LargePageTrailerOffset(size_t numBytes)
+	{
+		return (numBytes + 63) / 64 * 64;
+	}
+
+	// Allocates numBytes aligned to a 64-byte cache line, or to a large page when backed by large pages. Returns NULL when out of memory.
+	inline void* allocate_large_page_bytes(size_t numBytes)
+	{
+		size_t trailerOffset = _LargePageTrailerOffset(numBytes);
+		size_t totalBytes    = trailerOffset + sizeof(_LargePageBufferTrailer);
+		_LargePageBufferTrailer trailer = { NULL, totalBytes, _LargePageBufferTrailer::OperatorNew };
+		LargePageMode mode = large_page_mode();
+		if (numBytes >= LargePageMinimumBytes && mode != LargePageMode::Off)
+		{
+#if defined(_WIN32)
+			if (mode == LargePageMode::Explicit && GetLargePageMinimum() != 0)
+			{
+				size_t largePageBytes = (totalBytes + GetLargePageMinimum() - 1) / GetLargePageMinimum() * GetLargePageMinimum();
+				trailer.base = VirtualAlloc(NULL, largePageBytes, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+				trailer.mappedBytes = largePageBytes;
+			}
+			if (trailer.base == NULL)
+			{
+				trailer.base = VirtualAlloc(NULL, totalBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+				trailer.mappedBytes = totalBytes;
+			}
+			if (trailer.base != NULL)
+				trailer.kind = _LargePageBufferTrailer::VirtualAllocation;
+#else
+#if defined(MAP_HUGETLB)
+			if (mode == LargePageMode::Explicit)
+			{
+				size_t hugeBytes = (totalBytes + LargePageSize - 1) / LargePageSize * LargePageSize;
+				void* mapped = mmap(NULL, hugeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+				if (mapped != MAP_FAILED)
+				{
+					trailer.base        = mapped;
+					trailer.mappedBytes = hugeBytes;
+				}
+			}
+#endif
+			if (trailer.base == NULL)
+			{
+				// Map an extra large page, and trim the mapping to start on a large page boundary, since only aligned 2 MB regions can become huge pages
+				size_t pageBytes   = (totalBytes + 4095) / 4096 * 4096;
+				size_t mappedBytes = pageBytes + LargePageSize;
+				char* mapped = static_cast<char*>(mmap(NULL, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+				if (mapped != MAP_FAILED)
+				{
+					char* aligned = reinterpret_cast<char*>(((uintptr_t)mapped + LargePageSize - 1) & ~(uintptr_t)(LargePageSize - 1));
+					if (aligned != mapped)
+						munmap(mapped, aligned - mapped);
+					if (aligned + pageBytes != mapped + mappedBytes)
+						munmap(aligned + pageBytes, (mapped + mappedBytes) - (aligned + pageBytes));
+#if defined(MADV_HUGEPAGE)
+					madvise(aligned, pageBytes, MADV_HUGEPAGE);
+#endif
+					trailer.base        = aligned;
+					trailer.mappedBytes = pageBytes;
+				}
+			}
+			if (trailer.base != NULL)
+				trailer.kind = _LargePageBufferTrailer::MemoryMap;
+#endif
+		}
+		if (trailer.base == NULL)
+		{
+			trailer.base = operator new[](totalBytes, (std::align_val_t)(64), std::nothrow);
+			if (trailer.base == NULL)
+				return NULL;
+		}
+		*reinterpret_cast<_LargePageBufferTrailer*>(static_cast<char*>(trailer.base) + trailerOffset) = trailer;
+		return trailer.base;
+	}
+
+	// Frees a buffer of numBytes from allocate_large_page_bytes. numBytes must be the same as for the allocation.
+	inline void free_large_page_bytes(void* buffer, size_t numBytes)
+	{
+		if (buffer == NULL)
+			return;
+		_LargePageBufferTrailer trailer = *reinterpret_cast<_LargePageBufferTrailer*>(static_cast<char*>(buffer) + _LargePageTrailerOffset(numBytes));
+		switch (trailer.kind)
+		{
+#if defined(_WIN32)
+		case _LargePageBufferTrailer::VirtualAllocation:  VirtualFree(trailer.base, 0, MEM_RELEASE);  break;
+#else
+		case _LargePageBufferTrailer::MemoryMap:          munmap(trailer.base, trailer.mappedBytes);  break;
+#endif
+		default:  ::operator delete[](trailer.base, std::align_val_t{ 64 });  break;
+		}
+	}
+
+	// Working buffer of "size" elements, backed by large pages for trivial types (e.g. keys being sorted), and allocated by new[] otherwise.
+	// Same as new, elements of trivial types are left uninitialized. Returns NULL when out of memory, same as new(std::nothrow).
+	template< class _Type >
+	inline _Type* allocate_working_buffer(size_t size, const std::nothrow_t&)
+	{
+		if constexpr (std::is_trivially_default_constructible< _Type >::value && std::is_trivially_destructible< _Type >::value)
+		{
+			if (size > SIZE_MAX / sizeof(_Type))
+				return NULL;
+			return static_cast<_Type*>(allocate_large_page_bytes(size * sizeof(_Type)));
+		}
+		else
+			return new(std::nothrow) _Type[size];
+	}
+
+	// Same as above, throwing std::bad_alloc when out of memory, same as new
+	template< class _Type >
+	inline _Type* allocate_working_buffer(size_t size)
+	{
+		_Type* buffer = allocate_working_buffer< _Type >(size, std::nothrow);
+		if (buffer == NULL)
+			throw std::bad_alloc();
+		return buffer;
+	}
+
+	// Frees a buffer of "size" elements from allocate_working_buffer
+	template< class _Type >
+	inline void free_working_buffer(_Type* buffer, size_t size)
+	{
+		if constexpr (std::is_trivially_default_constructible< _Type >::value && std::is_trivially_destructible< _Type >::value)
+			free_large_page_bytes(buffer, size * sizeof(_Type));
+		else
+			delete[] buffer;
+	}
+}
+
+#endif
@@ -0,0 +1,415 @@
+// Merge of two sorted arrays using SIMD bitonic merge networks (AVX2 and AVX-512), for arrays of 32-bit and 64-bit keys:
+// unsigned, int, float, unsigned long long and double. Each step merges a vector of the smallest remaining elements with a vector
+// of the largest elements output so far, using the in-register bitonic merge network of Inoue et al. "AA-sort" (PACT 2007)
+// and Chhugani et al. "Efficient implementation of sorting on multi-core SIMD CPU architecture" (VLDB 2008).
+// The instruction set is selected at run-time using CPUID, and callers fall back to the scalar merge when SIMD is not supported.
+
+#ifndef _MergeSimd_h
+#define _MergeSimd_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MERGE_SIMD_SUPPORTED
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Functions using AVX2 or AVX-512 instructions are compiled for that instruction set, without requiring it for the rest of the program (e.g. -mavx2)
+#if defined(__GNUC__) || defined(__clang__)
+#define MERGE_SIMD_TARGET_AVX2   __attribute__((target("avx2")))
+#define MERGE_SIMD_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define MERGE_SIMD_TARGET_AVX2
+#define MERGE_SIMD_TARGET_AVX512
+#endif
+
+namespace ParallelAlgorithms
+{
+	enum class MergeSimdLevel
+	{
+		Scalar,		// scalar merge only
+		Avx2,		// 256-bit vectors: 8 keys of 32-bits, or 4 keys of 64-bits
+		Avx512		// 512-bit vectors: 16 keys of 32-bits, or 8 keys of 64-bits
+	};
+
+	// Highest SIMD instruction set supported by both the CPU and the OS (which saves the wider registers on context switches)
+	inline MergeSimdLevel _DetectMergeSimdLevel()
+	{
+#if defined(MERGE_SIMD_SUPPORTED)
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return MergeSimdLevel::Scalar;
+		__cpuid(info, 1);
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x06) == 0x06;	// OSXSAVE and AVX, with XMM and YMM state enabled
+		if (!osSavesYmm)
+			return MergeSimdLevel::Scalar;
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 16)) != 0 && (_xgetbv(0) & 0xE6) == 0xE6)		// AVX512F, with opmask and ZMM state enabled
+			return MergeSimdLevel::Avx512;
+		if ((info[1] & (1 << 5)) != 0)										// AVX2
+			return MergeSimdLevel::Avx2;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+			return MergeSimdLevel::Avx512;
+		if (__builtin_cpu_supports("avx2"))
+			return MergeSimdLevel::Avx2;
+#endif
+#endif
+		return MergeSimdLevel::Scalar;
+	}
+
+	inline MergeSimdLevel merge_simd_level_supported()
+	{
+		static const MergeSimdLevel level = _DetectMergeSimdLevel();
+		return level;
+	}
+
+	inline std::atomic< MergeSimdLevel >& _MergeSimdLevelSetting()
+	{
+		static std::atomic< MergeSimdLevel > level{ merge_simd_level_supported() };
+		return level;
+	}
+
+	// SIMD instruction set used by merges after this call, limited to the one supported by the CPU (the highest supported by default).
+	// Lowering to Avx2 avoids the lower clock frequency of some CPUs running AVX-512, and Scalar disables SIMD merge.
+	inline void merge_simd_level(MergeSimdLevel level)
+	{
+		_MergeSimdLevelSetting() = (int)level < (int)merge_simd_level_supported() ? level : merge_simd_level_supported();
+	}
+	inline MergeSimdLevel merge_simd_level() { return _MergeSimdLevelSetting().load(std::memory_order_relaxed); }
+
+	template< class _Type >
+	inline void _MergeSimdScalar(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+		while (a_start < a_end && b_start < b_end) {
+			if (*a_start <= *b_start)	*dst++ = *a_start++;
+			else						*dst++ = *b_start++;
+		}
+		while (a_start < a_end)	*dst++ = *a_start++;
+		while (b_start < b_end)	*dst++ = *b_start++;
+	}
+
+	// Merges the last vector of the largest elements (tail[0 .. Lanes)), which are no smaller than all of the output so far, with the rest of the two arrays.
+	// The array with fewer elements left has less than a vector left, and is merged with the tail first.
+	template< size_t Lanes, class _Type >
+	inline void _MergeSimdTail(const _Type* tail, const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+		_Type shortMerged[2 * Lanes];
+		if ((a_end - a_start) <= (b_end - b_start)) {
+			_MergeSimdScalar(a_start, a_end, tail, tail + Lanes, shortMerged);
+			_MergeSimdScalar(shortMerged, shortMerged + Lanes + (a_end - a_start), b_start, b_end, dst);
+		}
+		else {
+			_MergeSimdScalar(tail, tail + Lanes, b_start, b_end, shortMerged);
+			_MergeSimdScalar(a_start, a_end, shortMerged, shortMerged + Lanes + (b_end - b_start), dst);
+		}
+	}
+
+#if defined(MERGE_SIMD_SUPPORTED)
+	// Vector operations of each key type. min(a, b) returns b where b < a, otherwise a, and max(a, b) returns b where a < b, otherwise a.
+	// Both exchange the two keys of a lane only when they compare in the opposite order, and keep the keys comparing equal (such as -0.0 and 0.0) or
+	// unordered (NaN) in place, which preserves all of the keys, same as the scalar merge. Permutes are done on the bits of the vector.
+	struct _MergeSimdAvx2U32
+	{
+		typedef __m256i Vector;
+		static const size_t Lanes = 8;
+		static MERGE_SIMD_TARGET_AVX2 Vector  load(const void* src)       { return _mm256_loadu_si256(static_cast<const __m256i*>(src)); }
+		static MERGE_SIMD_TARGET_AVX2 void    store(void* dst, Vector v)  { _mm256_storeu_si256(static_cast<__m256i*>(dst), v); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  min(Vector a, Vector b)     { return _mm256_min_epu32(a, b); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  max(Vector a, Vector b)     { return _mm256_max_epu32(a, b); }
+		static MERGE_SIMD_TARGET_AVX2 __m256i bits(Vector v)              { return v; }
+		static MERGE_SIMD_TARGET_AVX2 Vector  vector(__m256i v)           { return v; }
+	};
+	struct _MergeSimdAvx2I32 : _MergeSimdAvx2U32
+	{
+		static MERGE_SIMD_TARGET_AVX2 Vector  min(Vector a, Vector b)     { return _mm256_min_epi32(a, b); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  max(Vector a, Vector b)     { return _mm256_max_epi32(a, b); }
+	};
+	struct _MergeSimdAvx2F32
+	{
+		typedef __m256 Vector;
+		static const size_t Lanes = 8;
+		static MERGE_SIMD_TARGET_AVX2 Vector  load(const void* src)       { return _mm256_loadu_ps(static_cast<const float*>(src)); }
+		static MERGE_SIMD_TARGET_AVX2 void    store(void* dst, Vector v)  { _mm256_storeu_ps(static_cast<float*>(dst), v); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  min(Vector a, Vector b)     { return _mm256_min_ps(b, a); }		// returns the second operand when equal or unordered
+		static MERGE_SIMD_TARGET_AVX2 Vector  max(Vector a, Vector b)     { return _mm256_max_ps(b, a); }
+		static MERGE_SIMD_TARGET_AVX2 __m256i bits(Vector v)              { return _mm256_castps_si256(v); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  vector(__m256i v)           { return _mm256_castsi256_ps(v); }
+	};
+	struct _MergeSimdAvx2U64
+	{
+		typedef __m256i Vector;
+		static const size_t Lanes = 4;
+		static MERGE_SIMD_TARGET_AVX2 Vector  load(const void* src)       { return _mm256_loadu_si256(static_cast<const __m256i*>(src)); }
+		static MERGE_SIMD_TARGET_AVX2 void    store(void* dst, Vector v)  { _mm256_storeu_si256(static_cast<__m256i*>(dst), v); }
+		static MERGE_SIMD_TARGET_AVX2 __m256i bits(Vector v)              { return v; }
+		static MERGE_SIMD_TARGET_AVX2 Vector  vector(__m256i v)           { return v; }
+		// AVX2 has no unsigned 64-bit min/max or compare: flipping the sign bit turns the signed compare into an unsigned one
+		static MERGE_SIMD_TARGET_AVX2 __m256i less(Vector a, Vector b)
+		{
+			const __m256i signBit = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+			return _mm256_cmpgt_epi64(_mm256_xor_si256(b, signBit), _mm256_xor_si256(a, signBit));
+		}
+		static MERGE_SIMD_TARGET_AVX2 Vector  min(Vector a, Vector b)     { return _mm256_blendv_epi8(a, b, less(b, a)); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  max(Vector a, Vector b)     { return _mm256_blendv_epi8(a, b, less(a, b)); }
+	};
+	struct _MergeSimdAvx2F64
+	{
+		typedef __m256d Vector;
+		static const size_t Lanes = 4;
+		static MERGE_SIMD_TARGET_AVX2 Vector  load(const void* src)       { return _mm256_loadu_pd(static_cast<const double*>(src)); }
+		static MERGE_SIMD_TARGET_AVX2 void    store(void* dst, Vector v)  { _mm256_storeu_pd(static_cast<double*>(dst), v); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  min(Vector a, Vector b)     { return _mm256_min_pd(b, a); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  max(Vector a, Vector b)     { return _mm256_max_pd(b, a); }
+		static MERGE_SIMD_TARGET_AVX2 __m256i bits(Vector v)              { return _mm256_castpd_si256(v); }
+		static MERGE_SIMD_TARGET_AVX2 Vector  vector(__m256i v)           { return _mm256_castsi256_pd(v); }
+	};
+
+	// One step of the bitonic merge within a vector: compare-exchange of each lane with the lane "Distance" away, with the smaller key going to the lower lane
+	template< class _Ops, int Distance >
+	inline MERGE_SIMD_TARGET_AVX2 typename _Ops::Vector _BitonicStepAvx2(typename _Ops::Vector v)
+	{
+		__m256i x = _Ops::bits(v), partner;
+		const int distanceInBits = Distance * (int)(256 / _Ops::Lanes);
+		if constexpr (distanceInBits == 128)     partner = _mm256_permute2x128_si256(x, x, 0x01);
+		else if constexpr (distanceInBits == 64) partner = _mm256_shuffle_epi32(x, 0x4E);
+		else                                     partner = _mm256_shuffle_epi32(x, 0xB1);
+		typename _Ops::Vector p = _Ops::vector(partner);
+		__m256i lower = _Ops::bits(_Ops::min(v, p));
+		__m256i upper = _Ops::bits(_Ops::max(v, p));
+		if constexpr (distanceInBits == 128)     return _Ops::vector(_mm256_blend_epi32(lower, upper, 0xF0));	// mask of the upper 32-bit elements of each compared pair
+		else if constexpr (distanceInBits == 64) return _Ops::vector(_mm256_blend_epi32(lower, upper, 0xCC));
+		else                                     return _Ops::vector(_mm256_blend_epi32(lower, upper, 0xAA));
+	}
+
+	// Merges two sorted vectors: the smallest half of their keys ends up sorted in "a", and the largest half sorted in "b"
+	template< class _Ops >
+	inline MERGE_SIMD_TARGET_AVX2 void _BitonicMergeAvx2(typename _Ops::Vector& a, typename _Ops::Vector& b)
+	{
+		__m256i reversed;
+		if constexpr (_Ops::Lanes == 8) reversed = _mm256_permutevar8x32_epi32(_Ops::bits(b), _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+		else                            reversed = _mm256_permute4x64_epi64(_Ops::bits(b), 0x1B);
+		typename _Ops::Vector r  = _Ops::vector(reversed);
+		typename _Ops::Vector lo = _Ops::min(a, r);		// a followed by reversed b is a bitonic sequence, which this step splits into two bitonic halves
+		typename _Ops::Vector hi = _Ops::max(r, a);
+		if constexpr (_Ops::Lanes == 8) {
+			lo = _BitonicStepAvx2< _Ops, 4 >(lo);  hi = _BitonicStepAvx2< _Ops, 4 >(hi);
+		}
+		lo = _BitonicStepAvx2< _Ops, 2 >(lo);  hi = _BitonicStepAvx2< _Ops, 2 >(hi);
+		lo = _BitonicStepAvx2< _Ops, 1 >(lo);  hi = _BitonicStepAvx2< _Ops, 1 >(hi);
+		a = lo;
+		b = hi;
+	}
+
+	// Returns false without merging when either array is smaller than a vector
+	template< class _Ops, class _Type >
+	inline MERGE_SIMD_TARGET_AVX2 bool _MergeSimdAvx2(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+		const size_t Lanes = _Ops::Lanes;
+		if ((size_t)(a_end - a_start) < Lanes || (size_t)(b_end - b_start) < Lanes)
+			return false;
+		typename _Ops::Vector lo = _Ops::load(a_start);
+		typename _Ops::Vector hi = _Ops::load(b_start);
+		a_start += Lanes;
+		b_start += Lanes;
+		_BitonicMergeAvx2< _Ops >(lo, hi);
+		_Ops::store(dst, lo);
+		dst += Lanes;
+		while ((size_t)(a_end - a_start) >= Lanes && (size_t)(b_end - b_start) >= Lanes)
+		{
+			bool takeA = *a_start <= *b_start;			// array with the smaller next key provides the next vector, selected without a branch
+			const _Type* src = takeA ? a_start : b_start;
+			a_start += takeA ? Lanes : 0;
+			b_start += takeA ? 0 : Lanes;
+			lo = _Ops::load(src);
+			_BitonicMergeAvx2< _Ops >(lo, hi);
+			_Ops::store(dst, lo);
+			dst += Lanes;
+		}
+		_Type tail[Lanes];
+		_Ops::store(tail, hi);
+		_MergeSimdTail< Lanes >(tail, a_start, a_end, b_start, b_end, dst);
+		return true;
+	}
+
+	// GCC 12 warns about the undefined vectors used inside of its AVX-512 intrinsics (GCC bug 105593)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+	struct _MergeSimdAvx512U32
+	{
+		typedef __m512i Vector;
+		static const size_t Lanes = 16;
+		static MERGE_SIMD_TARGET_AVX512 Vector  load(const void* src)       { return _mm512_loadu_si512(src); }
+		static MERGE_SIMD_TARGET_AVX512 void    store(void* dst, Vector v)  { _mm512_storeu_si512(dst, v); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  min(Vector a, Vector b)     { return _mm512_min_epu32(a, b); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  max(Vector a, Vector b)     { return _mm512_max_epu32(a, b); }
+		static MERGE_SIMD_TARGET_AVX512 __m512i bits(Vector v)              { return v; }
+		static MERGE_SIMD_TARGET_AVX512 Vector  vector(__m512i v)           { return v; }
+	};
+	struct _MergeSimdAvx512I32 : _MergeSimdAvx512U32
+	{
+		static MERGE_SIMD_TARGET_AVX512 Vector  min(Vector a, Vector b)     { return _mm512_min_epi32(a, b); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  max(Vector a, Vector b)     { return _mm512_max_epi32(a, b); }
+	};
+	struct _MergeSimdAvx512F32
+	{
+		typedef __m512 Vector;
+		static const size_t Lanes = 16;
+		static MERGE_SIMD_TARGET_AVX512 Vector  load(const void* src)       { return _mm512_loadu_ps(src); }
+		static MERGE_SIMD_TARGET_AVX512 void    store(void* dst, Vector v)  { _mm512_storeu_ps(dst, v); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  min(Vector a, Vector b)     { return _mm512_min_ps(b, a); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  max(Vector a, Vector b)     { return _mm512_max_ps(b, a); }
+		static MERGE_SIMD_TARGET_AVX512 __m512i bits(Vector v)              { return _mm512_castps_si512(v); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  vector(__m512i v)           { return _mm512_castsi512_ps(v); }
+	};
+	struct _MergeSimdAvx512U64
+	{
+		typedef __m512i Vector;
+		static const size_t Lanes = 8;
+		static MERGE_SIMD_TARGET_AVX512 Vector  load(const void* src)       { return _mm512_loadu_si512(src); }
+		static MERGE_SIMD_TARGET_AVX512 void    store(void* dst, Vector v)  { _mm512_storeu_si512(dst, v); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  min(Vector a, Vector b)     { return _mm512_min_epu64(a, b); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  max(Vector a, Vector b)     { return _mm512_max_epu64(a, b); }
+		static MERGE_SIMD_TARGET_AVX512 __m512i bits(Vector v)              { return v; }
+		static MERGE_SIMD_TARGET_AVX512 Vector  vector(__m512i v)           { return v; }
+	};
+	struct _MergeSimdAvx512F64
+	{
+		typedef __m512d Vector;
+		static const size_t Lanes = 8;
+		static MERGE_SIMD_TARGET_AVX512 Vector  load(const void* src)       { return _mm512_loadu_pd(src); }
+		static MERGE_SIMD_TARGET_AVX512 void    store(void* dst, Vector v)  { _mm512_storeu_pd(dst, v); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  min(Vector a, Vector b)     { return _mm512_min_pd(b, a); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  max(Vector a, Vector b)     { return _mm512_max_pd(b, a); }
+		static MERGE_SIMD_TARGET_AVX512 __m512i bits(Vector v)              { return _mm512_castpd_si512(v); }
+		static MERGE_SIMD_TARGET_AVX512 Vector  vector(__m512i v)           { return _mm512_castsi512_pd(v); }
+	};
+
+	template< class _Ops, int Distance >
+	inline MERGE_SIMD_TARGET_AVX512 typename _Ops::Vector _BitonicStepAvx512(typename _Ops::Vector v)
+	{
+		__m512i x = _Ops::bits(v), partner;
+		__mmask16 upperLanes;
+		const int distanceInBits = Distance * (int)(512 / _Ops::Lanes);
+		if constexpr (distanceInBits == 256)      { partner = _mm512_shuffle_i32x4(x, x, 0x4E);              upperLanes = 0xFF00; }
+		else if constexpr (distanceInBits == 128) { partner = _mm512_shuffle_i32x4(x, x, 0xB1);              upperLanes = 0xF0F0; }
+		else if constexpr (distanceInBits ==  64) { partner = _mm512_shuffle_epi32(x, (_MM_PERM_ENUM)0x4E);  upperLanes = 0xCCCC; }
+		else                                      { partner = _mm512_shuffle_epi32(x, (_MM_PERM_ENUM)0xB1);  upperLanes = 0xAAAA; }
+		typename _Ops::Vector p = _Ops::vector(partner);
+		return _Ops::vector(_mm512_mask_blend_epi32(upperLanes, _Ops::bits(_Ops::min(v, p)), _Ops::bits(_Ops::max(v, p))));
+	}
+
+	template< class _Ops >
+	inline MERGE_SIMD_TARGET_AVX512 void _BitonicMergeAvx512(typename _Ops::Vector& a, typename _Ops::Vector& b)
+	{
+		__m512i reversed;
+		if constexpr (_Ops::Lanes == 16) reversed = _mm512_permutexvar_epi32(_mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _Ops::bits(b));
+		else                             reversed = _mm512_permutexvar_epi64(_mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7), _Ops::bits(b));
+		typename _Ops::Vector r  = _Ops::vector(reversed);
+		typename _Ops::Vector lo = _Ops::min(a, r);
+		typename _Ops::Vector hi = _Ops::max(r, a);
+		if constexpr (_Ops::Lanes == 16) {
+			lo = _BitonicStepAvx512< _Ops, 8 >(lo);  hi = _BitonicStepAvx512< _Ops, 8 >(hi);
+		}
+		lo = _BitonicStepAvx512< _Ops, 4 >(lo);  hi = _BitonicStepAvx512< _Ops, 4 >(hi);
+		lo = _BitonicStepAvx512< _Ops, 2 >(lo);  hi = _BitonicStepAvx512< _Ops, 2 >(hi);
+		lo = _BitonicStepAvx512< _Ops, 1 >(lo);  hi = _BitonicStepAvx512< _Ops, 1 >(hi);
+		a = lo;
+		b = hi;
+	}
+
+	template< class _Ops, class _Type >
+	inline MERGE_SIMD_TARGET_AVX512 bool _MergeSimdAvx512(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+		const size_t Lanes = _Ops::Lanes;
+		if ((size_t)(a_end - a_start) < Lanes || (size_t)(b_end - b_start) < Lanes)
+			return false;
+		typename _Ops::Vector lo = _Ops::load(a_start);
+		typename _Ops::Vector hi = _Ops::load(b_start);
+		a_start += Lanes;
+		b_start += Lanes;
+		_BitonicMergeAvx512< _Ops >(lo, hi);
+		_Ops::store(dst, lo);
+		dst += Lanes;
+		while ((size_t)(a_end - a_start) >= Lanes && (size_t)(b_end - b_start) >= Lanes)
+		{
+			bool takeA = *a_start <= *b_start;
+			const _Type* src = takeA ? a_start : b_start;
+			a_start += takeA ? Lanes : 0;
+			b_start += takeA ? 0 : Lanes;
+			lo = _Ops::load(src);
+			_BitonicMergeAvx512< _Ops >(lo, hi);
+			_Ops::store(dst, lo);
+			dst += Lanes;
+		}
+		_Type tail[Lanes];
+		_Ops::store(tail, hi);
+		_MergeSimdTail< Lanes >(tail, a_start, a_end, b_start, b_end, dst);
+		return true;
+	}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+	template< class _Avx2Ops, class _Avx512Ops, class _Type >
+	inline bool _MergeSimdDispatch(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+		switch (merge_simd_level())
+		{
+		case MergeSimdLevel::Avx512:  return _MergeSimdAvx512< _Avx512Ops >(a_start, a_end, b_start, b_end, dst);
+		case MergeSimdLevel::Avx2:    return _MergeSimdAvx2<   _Avx2Ops   >(a_start, a_end, b_start, b_end, dst);
+		default:                      return false;
+		}
+	}
+#endif
+
+	// Key types with a SIMD merge: 32-bit and 64-bit unsigned integers, 32-bit signed integers, float and double
+	template< class _Type >
+	struct merge_simd_supported : std::integral_constant< bool,
+		(std::is_integral< _Type >::value && !std::is_same< _Type, bool >::value && std::is_unsigned< _Type >::value && (sizeof(_Type) == 4 || sizeof(_Type) == 8)) ||
+		(std::is_integral< _Type >::value && std::is_signed< _Type >::value && sizeof(_Type) == 4) ||
+		std::is_same< _Type, float >::value || std::is_same< _Type, double >::value > {};
+
+	// Key types whose SIMD merge outputs the same order as the scalar merge: integers, as equal integers are indistinguishable. The min/max of a bitonic merge
+	// may output equal floating-point keys (-0.0 and 0.0), and NaNs, in a different order than a[] before b[], which stable merges must not do.
+	template< class _Type >
+	struct merge_simd_order_preserving : std::integral_constant< bool, merge_simd_supported< _Type >::value && std::is_integral< _Type >::value > {};
+
+	// Merges sorted a[] and b[] into dst[] using SIMD, with _end pointing one past the last element. Returns false without merging when the key type
+	// has no SIMD merge, the CPU supports no SIMD merge (or merge_simd_level() is Scalar), or either array is smaller than a vector, for the caller to use the scalar merge.
+	// Keys comparing equal may be output in a different order than the scalar merge, which makes no difference for integers.
+	template< class _Type >
+	inline bool merge_simd(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+#if defined(MERGE_SIMD_SUPPORTED)
+		if constexpr (merge_simd_supported< _Type >::value)
+		{
+			if constexpr (std::is_floating_point< _Type >::value && sizeof(_Type) == 4)
+				return _MergeSimdDispatch< _MergeSimdAvx2F32, _MergeSimdAvx512F32 >(a_start, a_end, b_start, b_end, dst);
+			else if constexpr (std::is_floating_point< _Type >::value)
+				return _MergeSimdDispatch< _MergeSimdAvx2F64, _MergeSimdAvx512F64 >(a_start, a_end, b_start, b_end, dst);
+			else if constexpr (std::is_signed< _Type >::value)
+				return _MergeSimdDispatch< _MergeSimdAvx2I32, _MergeSimdAvx512I32 >(a_start, a_end, b_start, b_end, dst);
+			else if constexpr (sizeof(_Type) == 4)
+				return _MergeSimdDispatch< _MergeSimdAvx2U32, _MergeSimdAvx512U32 >(a_start, a_end, b_start, b_end, dst);
+			else
+				return _MergeSimdDispatch< _MergeSimdAvx2U64, _MergeSimdAvx512U64 >(a_start, a_end, b_start, b_end, dst);
+		}
+#endif
+		(void)a_start;  (void)a_end;  (void)b_start;  (void)b_end;  (void)dst;
+		return false;
+	}
+}
+
+#endif
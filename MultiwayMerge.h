@@ -0,0 +1,338 @@
+// Parallel k-way merge of many sorted runs (e.g. per-shard results, pre-sorted segments) in a single pass over memory, instead of log2(k) passes of pairwise merges.
+// The output is split into equal partitions by multi-sequence selection (splitters across all runs), and each partition is merged by a single task using a loser tree.
+// Stable: equal elements are output in the order of their runs, and in the order within each run.
+
+#ifndef _MultiwayMerge_h
+#define _MultiwayMerge_h
+
+#include "Configuration.h"
+#include "ParallelMerge.h"
+#include "RadixSortCommon.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ParallelAlgorithms
+{
+	// Multi-sequence selection: splits k sorted runs at output rank "rank" of their stable merge, with split[i] elements of run i coming before the rank.
+	// Narrows a window [low, high) of the split in every run, using a pivot from the middle of the largest window, with the block of elements equal to
+	// the pivot found in each window by lower_bound and upper_bound. A rank before or after the block narrows every window to that side of it. A rank
+	// within the block is split there, taking its equal elements in the order of their runs, as the stable merge does. Runs with many equal elements
+	// (e.g. low-cardinality keys) are thus split in a single step, instead of narrowing one run at a time.
+	template< class _Type >
+	inline void multi_sequence_select(const _Type* const* run_start, const size_t* run_size, size_t k, size_t rank, size_t* split)
+	{
+		std::vector< size_t > low(k, 0), high(run_size, run_size + k), below(k), through(k);
+		while (true)
+		{
+			size_t sum_low = 0, sum_high = 0, largest = 0;
+			for (size_t i = 0; i < k; i++)
+			{
+				sum_low  += low[i];
+				sum_high += high[i];
+				if (high[i] - low[i] > high[largest] - low[largest])
+					largest = i;
+			}
+			if (sum_low == rank)  { std::copy(low.begin(),  low.end(),  split);  return; }
+			if (sum_high == rank) { std::copy(high.begin(), high.end(), split);  return; }
+
+			const _Type& pivot = run_start[largest][low[largest] + (high[largest] - low[largest]) / 2];
+			size_t sum_below = 0, sum_through = 0;				// number of elements before the block of the pivot, and up to its end
+			for (size_t i = 0; i < k; i++)
+			{
+				below[i]   = std::lower_bound(run_start[i] + low[i],   run_start[i] + high[i], pivot) - run_start[i];
+				through[i] = (below[i] == high[i] || pivot < run_start[i][below[i]]) ? below[i]		// no elements equal to the pivot, for most runs of distinct keys
+					: std::upper_bound(run_start[i] + below[i] + 1, run_start[i] + high[i], pivot) - run_start[i];
+				sum_below   += below[i];
+				sum_through += through[i];
+			}
+			if (rank <= sum_below)								// block of the pivot and all elements after it come after the rank
+				high.swap(below);
+			else if (rank >= sum_through)						// block of the pivot and all elements before it come before the rank
+				low.swap(through);
+			else												// rank is within the block of the pivot
+			{
+				size_t remaining = rank - sum_below;
+				for (size_t i = 0; i < k; i++)
+				{
+					size_t equal = (std::min)(through[i] - below[i], remaining);
+					split[i]   = below[i] + equal;
+					remaining -= equal;
+				}
+				return;
+			}
+		}
+	}
+
+	// Tournament tree of losers over k non-empty runs: the winner (the run with the smallest current element) is held apart from the tree, and each
+	// internal node tree[1 .. k) holds the loser of its match, with run i as leaf k + i. Replacing the winner's element takes one match per level,
+	// against losers only. Nodes hold the current element of their run along with the run, which keeps each match within a single node of the tree.
+	// Matches are ordered by (element, run), which outputs equal elements of lower runs first. An exhausted run r becomes run k + r, which loses
+	// every match: with a maximum element as a sentinel for arithmetic types (elements equal to the maximum still win, having a lower run),
+	// or by comparing runs against k otherwise.
+	template< class _Type >
+	class _LoserTree
+	{
+		struct _Node
+		{
+			_Type  key;
+			size_t run;
+		};
+		static const bool HasSentinel = std::is_arithmetic< _Type >::value;
+
+	public:
+		_LoserTree(const _Type* const* start, const _Type* const* end, size_t k) : m_current(start, start + k), m_end(end, end + k), m_tree(k)
+		{
+			m_winner = play(1);
+		}
+
+		// Outputs the next "count" elements of the merge
+		void merge(_Type* dst, size_t count)
+		{
+			const size_t k = m_tree.size();
+			_Node*              tree    = m_tree.data();
+			const _Type**       current = m_current.data();
+			const _Type* const* end     = m_end.data();
+			_Type  winnerKey = m_winner.key;
+			size_t winnerRun = m_winner.run;
+			for (size_t n = 0; n < count; n++)
+			{
+				*dst++ = winnerKey;
+				size_t leaf = winnerRun + k;
+				if (++current[winnerRun] != end[winnerRun])
+					winnerKey = *current[winnerRun];
+				else
+				{
+					if constexpr (HasSentinel)
+						winnerKey = sentinel();
+					winnerRun += k;
+				}
+				for (size_t node = leaf / 2; node > 0; node /= 2)
+				{
+					_Node& loser = tree[node];
+					bool loserWins = before(loser.key, loser.run, winnerKey, winnerRun, k);
+					exchange(loserWins, loser.key, winnerKey);
+					exchange(loserWins, loser.run, winnerRun);
+				}
+			}
+			m_winner.key = winnerKey;
+			m_winner.run = winnerRun;
+		}
+
+	private:
+		static _Type sentinel()
+		{
+			return std::numeric_limits< _Type >::has_infinity ? std::numeric_limits< _Type >::infinity() : (std::numeric_limits< _Type >::max)();
+		}
+
+		// Exchanges a and b when "condition" is true. Integers are exchanged using a mask, as compilers turn a conditional exchange into a branch,
+		// which is mispredicted half of the time for random data
+		template< class _Value >
+		static void exchange(bool condition, _Value& a, _Value& b)
+		{
+			if constexpr (std::is_integral< _Value >::value)
+			{
+				_Value difference = (a ^ b) & (_Value)(0 - (_Value)condition);
+				a ^= difference;
+				b ^= difference;
+			}
+			else if (condition)
+				std::swap(a, b);
+		}
+
+		static bool before(const _Type& iKey, size_t i, const _Type& jKey, size_t j, size_t k)
+		{
+			bool inOrder = (iKey < jKey) | (!(jKey < iKey) & (i < j));	// equal elements of the lower run first
+			if constexpr (HasSentinel)
+				return inOrder;
+			else
+				return (i < k) & ((j >= k) | inOrder);
+		}
+
+		_Node play(size_t node)		// returns the winner of the subtree, storing losers of its matches
+		{
+			const size_t k = m_tree.size();
+			if (node >= k)
+				return _Node{ *m_current[node - k], node - k };
+			_Node left  = play(2 * node);
+			_Node right = play(2 * node + 1);
+			bool leftWins = before(left.key, left.run, right.key, right.run, k);
+			m_tree[node] = leftWins ? right : left;
+			return leftWins ? left : right;
+		}
+
+		std::vector< const _Type* > m_current;
+		std::vector< const _Type* > m_end;
+		std::vector< _Node >        m_tree;
+		_Node                       m_winner;
+	};
+
+	// Loser tree of integer elements of up to 32 bits, with the (element, run) of each node packed into a single 64-bit word: the order-preserving
+	// unsigned representation of the element (see RadixKeyTransform) above the run. Each match is then a single compare and a masked exchange of one word.
+	// An exhausted run r becomes (maximum, k + r), which loses every match. Supports fewer than 2^31 runs.
+	template< class _Type >
+	struct _LoserTreePackable : std::integral_constant< bool, std::is_integral< _Type >::value && !std::is_same< _Type, bool >::value && sizeof(_Type) <= 4 > {};
+
+	template< class _Type >
+	class _LoserTreePacked
+	{
+		typedef RadixKeyTransform< _Type > _KeyTransform;
+		typedef typename _KeyTransform::UnsignedType _UnsignedType;
+
+	public:
+		static const size_t MaximumNumberOfRuns = ((size_t)1 << 31) - 1;
+
+		_LoserTreePacked(const _Type* const* start, const _Type* const* end, size_t k) : m_current(start, start + k), m_end(end, end + k), m_tree(k)
+		{
+			m_winner = play(1);
+		}
+
+		// Outputs the next "count" elements of the merge
+		void merge(_Type* dst, size_t count)
+		{
+			const size_t k = m_tree.size();
+			uint64_t*           tree    = m_tree.data();
+			const _Type**       current = m_current.data();
+			const _Type* const* end     = m_end.data();
+			uint64_t winner = m_winner;
+			for (size_t n = 0; n < count; n++)
+			{
+				size_t run = (size_t)(uint32_t)winner;
+				*dst++ = (_Type)_KeyTransform::from_unsigned((_UnsignedType)(winner >> 32));
+				size_t leaf = run + k;
+				winner = ++current[run] != end[run] ? pack(*current[run], run) : ((uint64_t)UINT32_MAX << 32) | leaf;
+				for (size_t node = leaf / 2; node > 0; node /= 2)
+				{
+					uint64_t loser = tree[node];
+					uint64_t difference = (loser ^ winner) & (0 - (uint64_t)(loser < winner));	// exchange using a mask, as compilers turn a conditional exchange into a branch
+					tree[node] = loser ^ difference;
+					winner    ^= difference;
+				}
+			}
+			m_winner = winner;
+		}
+
+	private:
+		static uint64_t pack(_Type element, size_t run)
+		{
+			return ((uint64_t)_KeyTransform::to_unsigned((_UnsignedType)element) << 32) | run;
+		}
+
+		uint64_t play(size_t node)	// returns the winner of the subtree, storing losers of its matches
+		{
+			const size_t k = m_tree.size();
+			if (node >= k)
+				return pack(*m_current[node - k], node - k);
+			uint64_t left  = play(2 * node);
+			uint64_t right = play(2 * node + 1);
+			m_tree[node] = (std::max)(left, right);
+			return (std::min)(left, right);
+		}
+
+		std::vector< const _Type* > m_current;
+		std::vector< const _Type* > m_end;
+		std::vector< uint64_t >     m_tree;
+		uint64_t                    m_winner;
+	};
+
+	// Serial k-way merge of runs [split_start[i], split_end[i]) into dst
+	template< class _Type >
+	inline void _MergeKWay(const _Type* const* run_start, const size_t* split_start, const size_t* split_end, size_t k, _Type* dst)
+	{
+		std::vector< const _Type* > current, end;
+		size_t count = 0;
+		for (size_t i = 0; i < k; i++)
+			if (split_end[i] > split_start[i])		// only the non-empty runs take part, in the same order
+			{
+				current.push_back(run_start[i] + split_start[i]);
+				end.push_back(    run_start[i] + split_end[i]);
+				count += split_end[i] - split_start[i];
+			}
+		if (current.size() == 1)
+			std::copy(current[0], end[0], dst);
+		else if (current.size() == 2)
+			merge_ptr_1(current[0], end[0], current[1], end[1], dst);
+		else if (current.size() > 2)
+		{
+			if constexpr (_LoserTreePackable< _Type >::value)
+				if (current.size() <= _LoserTreePacked< _Type >::MaximumNumberOfRuns)
+				{
+					_LoserTreePacked< _Type > tree(current.data(), end.data(), current.size());
+					tree.merge(dst, count);
+					return;
+				}
+			_LoserTree< _Type > tree(current.data(), end.data(), current.size());
+			tree.merge(dst, count);
+		}
+	}
+
+	template< class _Type >
+	inline void _MergeKWayPar(const _Type* const* run_start, const size_t* run_size, size_t k, _Type* dst, size_t numberOfPartitions, size_t minPartitionSize)
+	{
+		size_t dst_size = 0;
+		for (size_t i = 0; i < k; i++)
+			dst_size += run_size[i];
+		static const size_t processor_count = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+		if (numberOfPartitions == 0)
+			numberOfPartitions = processor_count;
+		numberOfPartitions = std::min(numberOfPartitions, std::max(dst_size / std::max(minPartitionSize, (size_t)1), (size_t)1));
+
+		// splits[p * k .. (p + 1) * k) are the splits of all runs at the start of partition p, with the first partition starting at 0 and the last one ending at run_size
+		std::vector< size_t > splits((numberOfPartitions + 1) * k, 0);
+		std::copy(run_size, run_size + k, splits.begin() + numberOfPartitions * k);
+		auto select = [&](size_t p)
+		{
+			multi_sequence_select(run_start, run_size, k, p * dst_size / numberOfPartitions, splits.data() + p * k);
+		};
+		auto merge_partition = [&](size_t p)
+		{
+			_MergeKWay(run_start, splits.data() + p * k, splits.data() + (p + 1) * k, k, dst + p * dst_size / numberOfPartitions);
+		};
+#if defined(USE_PPL)
+		Concurrency::parallel_for((size_t)1, numberOfPartitions, select);
+		Concurrency::parallel_for((size_t)0, numberOfPartitions, merge_partition);
+#else
+		tbb::parallel_for((size_t)1, numberOfPartitions, select);
+		tbb::parallel_for((size_t)0, numberOfPartitions, merge_partition);
+#endif
+	}
+
+	// Parallel k-way merge of sorted runs stored contiguously: run r is src[run_offsets[r] .. run_offsets[r + 1]), with number_of_runs + 1 offsets.
+	// All of the runs are merged into dst[0 .. run_offsets[number_of_runs] - run_offsets[0]).
+	// numberOfPartitions of 0 uses one partition per core, with each partition of at least minPartitionSize elements.
+	template< class _Type >
+	inline void merge_k_way_par(const _Type* src, const size_t* run_offsets, size_t number_of_runs, _Type* dst, size_t numberOfPartitions = 0, size_t minPartitionSize = 16 * 1024)
+	{
+		std::vector< const _Type* > run_start(number_of_runs);
+		std::vector< size_t > run_size(number_of_runs);
+		for (size_t r = 0; r < number_of_runs; r++)
+		{
+			run_start[r] = src + run_offsets[r];
+			run_size[ r] = run_offsets[r + 1] - run_offsets[r];
+		}
+		_MergeKWayPar(run_start.data(), run_size.data(), number_of_runs, dst, numberOfPartitions, minPartitionSize);
+	}
+
+	// Parallel k-way merge of sorted runs given as a vector of spans: any type with data() and size(), such as std::span (C++20) or std::vector
+	template< class _Span, class _Type >
+	inline void merge_k_way_par(const std::vector< _Span >& runs, _Type* dst, size_t numberOfPartitions = 0, size_t minPartitionSize = 16 * 1024)
+	{
+		static_assert(std::is_same< typename std::remove_cv< typename std::remove_pointer< decltype(runs[0].data()) >::type >::type, _Type >::value,
+			"element type of the runs must be the same as of the destination");
+		std::vector< const _Type* > run_start(runs.size());
+		std::vector< size_t > run_size(runs.size());
+		for (size_t r = 0; r < runs.size(); r++)
+		{
+			run_start[r] = runs[r].data();
+			run_size[ r] = runs[r].size();
+		}
+		_MergeKWayPar(run_start.data(), run_size.data(), runs.size(), dst, numberOfPartitions, minPartitionSize);
+	}
+}
+
+#endif
@@ -0,0 +1,68 @@
+// Copy using non-temporal (streaming) stores, which write directly to system memory, bypassing the cache.
+// Useful for large permutations, such as LSD Radix Sort, where the destination is not read again soon, and
+// cached writes only evict useful cache lines (and read each destination cache line before writing it).
+
+#ifndef _NonTemporalCopy_h
+#define _NonTemporalCopy_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NON_TEMPORAL_STORES_SUPPORTED
+#include <immintrin.h>
+#endif
+
+namespace ParallelAlgorithms
+{
+#if defined(__AVX__)
+	const size_t NonTemporalStoreSize = 32;		// bytes written by each streaming store instruction, which must be aligned to this size
+#else
+	const size_t NonTemporalStoreSize = 16;
+#endif
+
+	// Copies numBytes from source to destination, using streaming stores for the part of the destination aligned to NonTemporalStoreSize,
+	// and a regular memcpy for the unaligned head and tail. Falls back to memcpy for small copies, and when streaming stores are not supported.
+	// Streaming stores are weakly ordered: call nontemporal_store_fence() before other threads read the destination.
+	inline void memcpy_nontemporal(void* destination, const void* source, size_t numBytes)
+	{
+#if defined(NON_TEMPORAL_STORES_SUPPORTED)
+		char*       dst = static_cast<char*>(destination);
+		const char* src = static_cast<const char*>(source);
+		if (numBytes < 2 * NonTemporalStoreSize)
+		{
+			memcpy(dst, src, numBytes);
+			return;
+		}
+		size_t headBytes = (NonTemporalStoreSize - ((uintptr_t)dst & (NonTemporalStoreSize - 1))) & (NonTemporalStoreSize - 1);
+		memcpy(dst, src, headBytes);
+		dst      += headBytes;
+		src      += headBytes;
+		numBytes -= headBytes;
+
+		size_t bodyBytes = numBytes & ~(NonTemporalStoreSize - 1);
+		for (size_t i = 0; i < bodyBytes; i += NonTemporalStoreSize)
+		{
+#if defined(__AVX__)
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+#else
+			_mm_stream_si128(   reinterpret_cast<__m128i*>(dst + i), _mm_loadu_si128(   reinterpret_cast<const __m128i*>(src + i)));
+#endif
+		}
+		memcpy(dst + bodyBytes, src + bodyBytes, numBytes - bodyBytes);
+#else
+		memcpy(destination, source, numBytes);
+#endif
+	}
+
+	// Orders all previous streaming stores of this thread before any later stores, making them visible to other threads
+	inline void nontemporal_store_fence()
+	{
+#if defined(NON_TEMPORAL_STORES_SUPPORTED)
+		_mm_sfence();
+#endif
+	}
+}
+
+#endif
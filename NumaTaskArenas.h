@@ -0,0 +1,125 @@
+// NUMA-aware execution of tasks: one TBB task arena per NUMA node, with the tasks of each node running on the cores of that node.
+// Each node owns a contiguous slice of an array, and the pages of each slice are first-touched by its node, which places them in the memory of that node.
+// TBB-only implementation. Threads are pinned to the cores of a node when TBB finds its hwloc-based tbbbind library, otherwise only concurrency is limited per node.
+
+#ifndef _NumaTaskArenas_h
+#define _NumaTaskArenas_h
+
+#include "tbb/tbb.h"
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#include <tbb/info.h>
+
+#include <stddef.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace ParallelAlgorithms
+{
+	// numberOfSimulatedNodes larger than the number of NUMA nodes of the machine splits each node into several arenas, with the cores of the node divided among them.
+	// This exercises the NUMA code paths on a single-node machine (e.g. for testing), without the benefit of local memory.
+	class NumaTaskArenas
+	{
+	public:
+		explicit NumaTaskArenas(unsigned numberOfSimulatedNodes = 0)
+		{
+			std::vector< tbb::numa_node_id > numaNodes = tbb::info::numa_nodes();		// a single node of id -1, when not detected
+			size_t numberOfNodes   = (std::max)(numaNodes.size(), (size_t)numberOfSimulatedNodes);
+			size_t arenasPerNode   = (numberOfNodes + numaNodes.size() - 1) / numaNodes.size();
+			for (size_t i = 0; i < numberOfNodes; i++)
+			{
+				tbb::numa_node_id numaId = numaNodes[i % numaNodes.size()];
+				int concurrency = (std::max)(1, tbb::info::default_concurrency(numaId) / (int)arenasPerNode);
+				m_numaIds.push_back(numaId);
+				m_arenas.emplace_back(new tbb::task_arena(tbb::task_arena::constraints(numaId, concurrency)));
+				m_groups.emplace_back(new tbb::task_group);
+			}
+		}
+
+		NumaTaskArenas(const NumaTaskArenas&) = delete;
+		NumaTaskArenas& operator=(const NumaTaskArenas&) = delete;
+
+		size_t number_of_nodes() const { return m_arenas.size(); }
+
+		// NUMA node id of a node (arena), which is shared by several arenas when nodes are simulated
+		tbb::numa_node_id numa_id(size_t node) const { return m_numaIds[node]; }
+
+		// Node owning element "index" of an array of "size" elements: node k owns elements [k * size / nodes, (k + 1) * size / nodes)
+		size_t node_of(size_t index, size_t size) const
+		{
+			return size == 0 ? 0 : (std::min)(index * number_of_nodes() / size, number_of_nodes() - 1);
+		}
+
+		// Runs a task on the threads of a node, without waiting for it to complete
+		template< class _Function >
+		void run(size_t node, const _Function& f)
+		{
+			m_arenas[node]->execute([&] { m_groups[node]->run(f); });
+		}
+
+		// Waits for all tasks of all nodes to complete
+		void wait()
+		{
+			for (size_t node = 0; node < number_of_nodes(); node++)
+				m_arenas[node]->execute([&] { m_groups[node]->wait(); });
+		}
+
+		// Writes to every page of a freshly allocated array, from the threads of the node owning each page, which places the pages in the memory of that node
+		// The first touch of a page is what places it, and arrays which have already been written to keep their placement.
+		void first_touch(void* array, size_t numBytes, size_t pageSize = 4096)
+		{
+			char* bytes = static_cast<char*>(array);
+			for (size_t node = 0; node < number_of_nodes(); node++)
+			{
+				size_t startByte = node       * numBytes / number_of_nodes();
+				size_t   endByte = (node + 1) * numBytes / number_of_nodes();	// non-inclusive
+				run(node, [=] {
+					tbb::parallel_for(tbb::blocked_range< size_t >(startByte, endByte, 64 * pageSize), [=](const tbb::blocked_range< size_t >& range) {
+						for (size_t i = range.begin(); i < range.end(); i += pageSize)
+							bytes[i] = 0;
+						});
+					});
+			}
+			wait();
+		}
+
+	private:
+		std::vector< tbb::numa_node_id >                 m_numaIds;
+		std::vector< std::unique_ptr< tbb::task_arena > > m_arenas;
+		std::vector< std::unique_ptr< tbb::task_group > > m_groups;
+	};
+
+	// Task group of the work quanta of an array: tasks of each work quanta run on the node owning the start of that work quanta,
+	// or on any thread when numaArenas is NULL
+	class QuantaTaskGroup
+	{
+	public:
+		QuantaTaskGroup(NumaTaskArenas* numaArenas, size_t workQuantum, size_t size) : m_numaArenas(numaArenas), m_workQuantum(workQuantum), m_size(size) {}
+
+		template< class _Function >
+		void run(size_t q, const _Function& f)
+		{
+			if (m_numaArenas != NULL)
+				m_numaArenas->run(m_numaArenas->node_of(q * m_workQuantum, m_size), f);
+			else
+				m_group.run(f);
+		}
+
+		void wait()
+		{
+			if (m_numaArenas != NULL)
+				m_numaArenas->wait();
+			else
+				m_group.wait();
+		}
+
+	private:
+		NumaTaskArenas* m_numaArenas;
+		size_t          m_workQuantum;
+		size_t          m_size;
+		tbb::task_group m_group;
+	};
+}
+
+#endif
@@ -20,10 +20,26 @@ extern int ParallelInPlaceMergeSortBenchmark(vector<unsigned>& uints);
 extern int ParallelMergeSortBenchmark(       vector<unsigned>& uints);
 extern int main_quicksort();
 extern int ParallelMergeBenchmark();
+extern int ParallelMergeSimdBenchmark();
+extern int ParallelMergeKernelBenchmark();
+extern int ParallelMergePathBenchmark();
+extern int ParallelMergeKWayBenchmark();
+extern int ParallelMergeSortMultiwayBenchmark();
 extern int ParallelRadixSortLsdBenchmark(    vector<unsigned>& uints);
+extern int ParallelRadixSortLsdBenchmark64();
+extern int ParallelRadixSortLsdRecordsBenchmark();
+extern int ParallelRadixSortLsdWorkspaceBenchmark();
+extern int ParallelRadixSortLsdStreamingStoresBenchmark();
+extern int ParallelRadixSortLsdNbitBenchmark();
+extern int ParallelRadixSortLsdNumaBenchmark(unsigned numberOfSimulatedNodes = 0);
+extern int ParallelRadixSortLsdLargePagesBenchmark(bool explicitHugePages = false);
+extern int ParallelRadixSortLsdRangeBenchmark();
 extern int RadixSortMsdBenchmark(            vector<unsigned>& uints);
+extern int ParallelInPlaceMsdPermuteBenchmark(vector<unsigned>& uints);
+extern int InPlaceMsdBufferedPermuteBenchmark(vector<unsigned>& uints);
 extern void TestAverageOfTwoIntegers();
 extern int CountingSortBenchmark(            vector<unsigned>& uints);
+extern int CountingSortParallel16Benchmark(  vector<unsigned>& uints);
 extern int SumBenchmark(                     vector<unsigned>& uints);
 extern int SumBenchmarkChar(                 vector<unsigned>& uints);
 extern int SumBenchmark64(                   vector<unsigned>& uints);
@@ -122,8 +138,11 @@ int main()
 //	return 0;
 
 //	RadixSortMsdBenchmark(uints);
+//	ParallelInPlaceMsdPermuteBenchmark(uints);	// top digit permuted in-place by a single core vs. all cores
+//	InPlaceMsdBufferedPermuteBenchmark(uints);	// top digit permuted in-place with unbuffered vs. buffered swaps
 
 	//CountingSortBenchmark(uints);		// sorts uchar's and not ulongs
+	//CountingSortParallel16Benchmark(uints);	// 16-bit keys and 32-bit small-domain codes: Counting Sort vs. Radix Sort
 
 	//SumBenchmarkChar(uints);
 	//SumBenchmark(    uints);
@@ -139,6 +158,21 @@ int main()
 	//ParallelRadixSortLsdBenchmark(uints);
 
 	//ParallelMergeBenchmark();
+	//ParallelMergeSimdBenchmark();			// scalar vs. AVX2 vs. AVX-512 bitonic leaf merges of Parallel Merge and Parallel Merge Sort
+	//ParallelMergeKernelBenchmark();			// merge_ptr_1 vs. unrolled vs. branchless bidirectional leaf merges of Parallel Merge Sort
+	//ParallelMergePathBenchmark();			// recursive vs. merge-path Parallel Merge, from 16K to 64M elements
+	//ParallelMergeKWayBenchmark();			// single pass k-way vs. pairwise Parallel Merge of 8, 64 and 1024 sorted runs, of random and of low-cardinality keys
+	//ParallelMergeSortMultiwayBenchmark();	// binary tree of merges vs. single multiway merge pass Parallel Merge Sort
+
+	//ParallelRadixSortLsdBenchmark64();		// 100 million and 1 billion 64-bit keys
+
+	//ParallelRadixSortLsdRecordsBenchmark();	// 16-byte and 64-byte records sorted by a 64-bit key
+	//ParallelRadixSortLsdWorkspaceBenchmark();	// many 1 million element arrays, allocating every call vs. reusing a RadixSortWorkspace
+	//ParallelRadixSortLsdStreamingStoresBenchmark();	// arrays much larger than the cache, memcpy vs. streaming store flushes
+	//ParallelRadixSortLsdNbitBenchmark();		// 8-bit vs. 11-bit vs. cache-size selected digits
+	//ParallelRadixSortLsdNumaBenchmark();		// NUMA mode on multi-socket machines, or ParallelRadixSortLsdNumaBenchmark(2) to simulate 2 nodes
+	//ParallelRadixSortLsdLargePagesBenchmark();			// 4 KB vs. 2 MB transparent huge pages, or ParallelRadixSortLsdLargePagesBenchmark(true) for reserved hugetlbfs pages
+	//ParallelRadixSortLsdRangeBenchmark();		// keys within a narrow range (IDs, timestamps of one day), all digits vs. range-compressed
 
 	//RadixSortLsdBenchmark(uints);
 
@@ -11,6 +11,7 @@
 
 #include "InsertionSort.h"
 #include "BinarySearch.h"
+#include "MergeSimd.h"
 
 #include <iostream>
 #include <algorithm>
@@ -49,9 +50,14 @@ namespace ParallelAlgorithms
 	}
 	// Faster Merge: see https://duvanenko.tech.blog/2018/07/25/faster-serial-merge-in-c-and-c/
 	// _end pointer point not to the last element, but one past and never access it - i.e. _end is not included
+	// Arrays of 32-bit and 64-bit integers are merged using SIMD bitonic merge (see MergeSimd.h), when the CPU supports AVX2 or AVX-512.
+	// Floating-point arrays are merged by the scalar merge, which keeps equal keys (-0.0 and 0.0) in a[] before b[] order, as stable merge sorts need.
 	template< class _Type >
 	inline void merge_ptr_1(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
 	{
+		if constexpr (merge_simd_order_preserving< _Type >::value)
+			if (merge_simd(a_start, a_end, b_start, b_end, dst))
+				return;
 		if (a_start < a_end && b_start < b_end) {
 			while (true) {
 				if (*a_start <= *b_start) {
@@ -115,6 +121,56 @@ namespace ParallelAlgorithms
 		while (a_start < a_end)	*dst++ = *a_start++;
 		while (b_start < b_end)	*dst++ = *b_start++;
 	}
+	// Branchless merge from both ends at the same time: the front stream outputs the smallest elements while the back stream outputs the largest,
+	// doubling instruction level parallelism, with the array to take each element from selected without a branch, removing mispredictions on random data.
+	// Both streams stay within both arrays for min(a_size, b_size) steps, and the rest (elements of the larger array only) is merged by merge_ptr_1.
+	// Stable, same as merge_ptr_1: for equal elements the front outputs a[] first, and the back outputs b[] last.
+	// _end pointer point not to the last element, but one past and never access it - i.e. _end is not included
+	template< class _Type >
+	inline void merge_ptr_bidirectional(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+		size_t a_size = a_end - a_start;
+		size_t b_size = b_end - b_start;
+		size_t steps  = std::min(a_size, b_size);
+		_Type* dst_end = dst + a_size + b_size;		// back stream writes to dst_end[-1], with a_end and b_end also one past the back element
+		for (size_t i = 0; i < steps; i++)
+		{
+			bool front_b = *b_start < *a_start;
+			const _Type* front = front_b ? b_start : a_start;
+			*dst++ = *front;
+			a_start += !front_b;
+			b_start +=  front_b;
+
+			bool back_a = b_end[-1] < a_end[-1];
+			const _Type* back = back_a ? a_end - 1 : b_end - 1;
+			*--dst_end = *back;
+			a_end -=  back_a;
+			b_end -= !back_a;
+		}
+		merge_ptr_1(a_start, a_end, b_start, b_end, dst);
+	}
+
+	// Leaf merge used by Parallel Merge (merge_parallel_L5) and the Parallel Merge Sorts built on it
+	enum class MergeKernel
+	{
+		Forward,			// merge_ptr_1, SIMD bitonic merge for arrays of integers when the CPU supports it (see MergeSimd.h)
+		ForwardUnrolled,	// merge_ptr_1_unrolled
+		Bidirectional,		// merge_ptr_bidirectional, branchless from both ends
+		Simd				// merge_simd for floats and doubles as well, which may output equal keys (-0.0 and 0.0) out of a[] before b[] order - not for stable sorts
+	};
+
+	template< class _Type >
+	inline void merge_ptr_kernel(MergeKernel kernel, const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
+	{
+		switch (kernel)
+		{
+		case MergeKernel::ForwardUnrolled:  merge_ptr_1_unrolled(   a_start, a_end, b_start, b_end, dst);  break;
+		case MergeKernel::Bidirectional:    merge_ptr_bidirectional(a_start, a_end, b_start, b_end, dst);  break;
+		case MergeKernel::Simd:             if (!merge_simd(a_start, a_end, b_start, b_end, dst))  merge_ptr_1(a_start, a_end, b_start, b_end, dst);  break;
+		default:                            merge_ptr_1(            a_start, a_end, b_start, b_end, dst);  break;
+		}
+	}
+
 	template< class _Type >
 	inline void merge_ptr_2(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst)
 	{
@@ -283,7 +339,7 @@ namespace ParallelAlgorithms
 
 	// Listing 5
 	template< class _Type >
-	inline void merge_parallel_L5(_Type* t, size_t p1, size_t r1, size_t p2, size_t r2, _Type* a, size_t p3, size_t parallel_threshold = 32768)
+	inline void merge_parallel_L5(_Type* t, size_t p1, size_t r1, size_t p2, size_t r2, _Type* a, size_t p3, size_t parallel_threshold = 32768, MergeKernel kernel = MergeKernel::Forward)
 	{
 		size_t length1 = r1 - p1 + 1;
 		size_t length2 = r2 - p2 + 1;
@@ -295,8 +351,9 @@ namespace ParallelAlgorithms
 		if (length1 == 0)	return;
 		if ((length1 + length2) <= parallel_threshold) {	// 8192 threshold is much better than 16. 32K seems to be an even better threshold
 			//merge_ptr( &t[ p1 ], &t[ p1 + length1 ], &t[ p2 ], &t[ p2 + length2 ], &a[ p3 ] );	// in DDJ paper
-			merge_ptr_1(&t[p1], &t[p1 + length1], &t[p2], &t[p2 + length2], &a[p3]);				// slightly faster than merge_ptr version due to fewer loop comparisons
+			//merge_ptr_1(&t[p1], &t[p1 + length1], &t[p2], &t[p2 + length2], &a[p3]);				// slightly faster than merge_ptr version due to fewer loop comparisons
 			//merge_ptr_3(&t[p1], &t[p1 + length1], &t[p2], &t[p2 + length2], &a[p3]);				// new merge concept, which turned out slower
+			merge_ptr_kernel(kernel, &t[p1], &t[p1 + length1], &t[p2], &t[p2 + length2], &a[p3]);
 		}
 		else {
 			size_t q1 = p1 / 2 + r1 / 2 + (p1 % 2 + r1 % 2) / 2;   // average without overflow
@@ -308,12 +365,67 @@ namespace ParallelAlgorithms
 #else
 			tbb::parallel_invoke(
 #endif
-				[&] { merge_parallel_L5(t, p1, q1 - 1, p2, q2 - 1, a, p3); },
-				[&] { merge_parallel_L5(t, q1 + 1, r1, q2, r2, a, q3 + 1); }
+				[&] { merge_parallel_L5(t, p1, q1 - 1, p2, q2 - 1, a, p3,     parallel_threshold, kernel); },
+				[&] { merge_parallel_L5(t, q1 + 1, r1, q2, r2, a, q3 + 1, parallel_threshold, kernel); }
 			);
 		}
 	}
 
+	// Co-rank of output index k: the number of elements of a[] among the first k elements of the merge of a[] and b[], with the other k - co-rank coming from b[].
+	// Binary search along the merge path (diagonal k). Equal elements of a[] come before those of b[], same as merge_ptr_1.
+	// Odeh, Green, Mwassi, Shmueli, Birk, "Merge Path - Parallel Merging Made Simple", IPDPS 2012
+	template< class _Type >
+	inline size_t merge_path_co_rank(size_t k, const _Type* a, size_t a_size, const _Type* b, size_t b_size)
+	{
+		size_t low  = k > b_size ? k - b_size : 0;
+		size_t high = std::min(k, a_size);
+		while (low < high)
+		{
+			size_t i = low + (high - low) / 2;
+			if (a[i] <= b[k - i - 1])	// a[i] is output before b[k - i - 1], which is within the first k
+				low = i + 1;
+			else
+				high = i;
+		}
+		return low;
+	}
+
+	// Merge-path Parallel Merge: splits the output into equal partitions up front, using co-rank searches, and merges each partition with a single task.
+	// Unlike merge_parallel_L5, which splits recursively at the midpoint of the larger array, each task merges the same number of elements for any input,
+	// with a single level of tasks, no recursive task tree, and co-rank searches done in parallel by the tasks themselves.
+	// numberOfPartitions of 0 uses one partition per core, with each partition of at least minPartitionSize elements, which keeps small merges on fewer cores.
+	// _end pointer point not to the last element, but one past and never access it - i.e. _end is not included
+	template< class _Type >
+	inline void merge_parallel_path(const _Type* a_start, const _Type* a_end, const _Type* b_start, const _Type* b_end, _Type* dst,
+		size_t numberOfPartitions = 0, size_t minPartitionSize = 4 * 1024, MergeKernel kernel = MergeKernel::Forward)
+	{
+		size_t a_size = a_end - a_start;
+		size_t b_size = b_end - b_start;
+		size_t dst_size = a_size + b_size;
+		static const size_t processor_count = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);	// detected once, as the query itself takes microseconds
+		if (numberOfPartitions == 0)
+			numberOfPartitions = processor_count;
+		numberOfPartitions = std::min(numberOfPartitions, std::max(dst_size / std::max(minPartitionSize, (size_t)1), (size_t)1));
+		if (numberOfPartitions <= 1)
+		{
+			merge_ptr_kernel(kernel, a_start, a_end, b_start, b_end, dst);
+			return;
+		}
+		auto merge_partition = [&](size_t p)
+		{
+			size_t k_start = p       * dst_size / numberOfPartitions;
+			size_t k_end   = (p + 1) * dst_size / numberOfPartitions;	// non-inclusive
+			size_t i_start = merge_path_co_rank(k_start, a_start, a_size, b_start, b_size);
+			size_t i_end   = merge_path_co_rank(k_end,   a_start, a_size, b_start, b_size);
+			merge_ptr_kernel(kernel, a_start + i_start, a_start + i_end, b_start + (k_start - i_start), b_start + (k_end - i_end), dst + k_start);
+		};
+#if defined(USE_PPL)
+		Concurrency::parallel_for((size_t)0, numberOfPartitions, merge_partition);
+#else
+		tbb::parallel_for((size_t)0, numberOfPartitions, merge_partition);
+#endif
+	}
+
 	template< class _Type >
 	inline void merge_parallel_quad(_Type* t, size_t p1, size_t r1, size_t p2, size_t r2, _Type* a, size_t p3)
 	{
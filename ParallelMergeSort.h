@@ -25,9 +25,11 @@
 #include "InsertionSort.h"
 #include "BinarySearch.h"
 #include "ParallelMerge.h"
+#include "MultiwayMerge.h"
 #include "RadixSortLSD.h"
 #include "RadixSortMSD.h"
 #include "RadixSortLsdParallel.h"
+#include "LargePageAllocator.h"
 #include "RadixSortMsdParallel.h"
 
 // TODO: This extern should not be needed and root-cause needs to be found
@@ -144,8 +146,10 @@ namespace ParallelAlgorithms
         else          merge_parallel_L5(dst, l, m, m + 1, r, src, l);
     }
 
+    // mergeKernel selects the leaf merge of the Parallel Merge (see MergeKernel in ParallelMerge.h)
     template< class _Type >
-    inline void parallel_merge_sort_hybrid_rh_2(_Type* src, size_t l, size_t r, _Type* dst, bool stable = true, bool srcToDst = true, size_t parallelThreshold = 32 * 1024)
+    inline void parallel_merge_sort_hybrid_rh_2(_Type* src, size_t l, size_t r, _Type* dst, bool stable = true, bool srcToDst = true, size_t parallelThreshold = 32 * 1024,
+                                                MergeKernel mergeKernel = MergeKernel::Forward)
     {
         if (r < l)  return;
         if (r == l) {   // termination/base case of sorting a single element
@@ -168,11 +172,11 @@ namespace ParallelAlgorithms
 #else
         tbb::parallel_invoke(
 #endif
-            [&] { parallel_merge_sort_hybrid_rh_2(src, l,     m, dst, stable, !srcToDst); },      // reverse direction of srcToDst for the next level of recursion
-            [&] { parallel_merge_sort_hybrid_rh_2(src, m + 1, r, dst, stable, !srcToDst); }       // reverse direction of srcToDst for the next level of recursion
+            [&] { parallel_merge_sort_hybrid_rh_2(src, l,     m, dst, stable, !srcToDst, 32 * 1024, mergeKernel); },      // reverse direction of srcToDst for the next level of recursion (with the default parallelThreshold)
+            [&] { parallel_merge_sort_hybrid_rh_2(src, m + 1, r, dst, stable, !srcToDst, 32 * 1024, mergeKernel); }       // reverse direction of srcToDst for the next level of recursion (with the default parallelThreshold)
         );
-        if (srcToDst) merge_parallel_L5(src, l, m, m + 1, r, dst, l);
-        else          merge_parallel_L5(dst, l, m, m + 1, r, src, l);
+        if (srcToDst) merge_parallel_L5(src, l, m, m + 1, r, dst, l, 32768, mergeKernel);
+        else          merge_parallel_L5(dst, l, m, m + 1, r, src, l, 32768, mergeKernel);
     }
 
     // Serial Merge Sort, using divide-and-conquer algorthm
@@ -306,6 +310,60 @@ namespace ParallelAlgorithms
         parallel_merge_sort_hybrid_radix_inner(src, l, r, dst, srcToDst, parallelThreshold);
     }
 
+    // Sorts numberOfChunks chunks of src[l..r] in parallel with leafSort(chunk, buffer, size), which sorts the chunk in-place using the same size buffer,
+    // and then merges all of the sorted chunks with a single parallel k-way merge (see MultiwayMerge.h), instead of a binary tree of merges,
+    // which passes over the whole array log2(numberOfChunks) times. Sorted result ends up in dst when srcToDst is true, and in src otherwise.
+    template< class _Type, class _LeafSort >
+    inline void parallel_merge_sort_multiway_inner(_Type* src, size_t l, size_t r, _Type* dst, bool srcToDst, size_t numberOfChunks, size_t minChunkSize, _LeafSort leafSort)
+    {
+        if (r < l)  return;
+        size_t src_size = r - l + 1;
+        static const size_t processor_count = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+        if (numberOfChunks == 0)
+            numberOfChunks = processor_count;
+        numberOfChunks = std::min(numberOfChunks, std::max(src_size / std::max(minChunkSize, (size_t)1), (size_t)1));
+
+        std::vector< size_t > chunkOffsets(numberOfChunks + 1);
+        for (size_t c = 0; c <= numberOfChunks; c++)
+            chunkOffsets[c] = l + c * src_size / numberOfChunks;
+        _Type* chunks = srcToDst ? src : dst;          // chunks are sorted in the array opposite of the result, for the merge to land in the result
+        _Type* other  = srcToDst ? dst : src;
+        auto sort_chunk = [&](size_t c)
+        {
+            size_t start = chunkOffsets[c], size = chunkOffsets[c + 1] - chunkOffsets[c];
+            if (!srcToDst)
+                std::copy(src + start, src + start + size, dst + start);
+            leafSort(chunks + start, other + start, size);
+        };
+#if defined(USE_PPL)
+        Concurrency::parallel_for((size_t)0, numberOfChunks, sort_chunk);
+#else
+        tbb::parallel_for((size_t)0, numberOfChunks, sort_chunk);
+#endif
+        merge_k_way_par(chunks, chunkOffsets.data(), numberOfChunks, other + l);
+    }
+
+    // Multiway Parallel Merge Sort: one chunk per core by default, or numberOfChunks (e.g. cache-sized) chunks, sorted by the same leaf sorts
+    // as parallel_merge_sort_hybrid_rh_2, followed by a single multiway merge pass
+    template< class _Type >
+    inline void parallel_merge_sort_multiway(_Type* src, size_t l, size_t r, _Type* dst, bool stable = true, bool srcToDst = true, size_t numberOfChunks = 0, size_t minChunkSize = 32 * 1024)
+    {
+        parallel_merge_sort_multiway_inner(src, l, r, dst, srcToDst, numberOfChunks, minChunkSize, [stable](_Type* chunk, _Type*, size_t size)
+        {
+            if (stable) std::stable_sort(chunk, chunk + size);
+            else        std::sort(       chunk, chunk + size);
+        });
+    }
+
+    // Multiway Parallel Merge Sort of unsigned integers, with chunks sorted by LSD Radix Sort
+    inline void parallel_merge_sort_multiway_radix(unsigned* src, size_t l, size_t r, unsigned* dst, bool srcToDst = true, size_t numberOfChunks = 0, size_t minChunkSize = 24 * 1024)
+    {
+        parallel_merge_sort_multiway_inner(src, l, r, dst, srcToDst, numberOfChunks, minChunkSize, [](unsigned* chunk, unsigned* buffer, size_t size)
+        {
+            RadixSortLSDPowerOf2Radix_unsigned_TwoPhase_DeRandomize(chunk, buffer, size);
+        });
+    }
+
     // Pure Serial Merge Sort, using divide-and-conquer algorthm
     template< class _Type >
     inline void merge_sort(_Type* src, size_t l, size_t r, _Type* dst, bool srcToDst = true)
@@ -514,7 +572,7 @@ inline void parallel_preventative_adaptive_inplace_merge_sort_2(_Type* src, size
     }
     else
     {
-        _Type* work_buff = new(std::nothrow) _Type[src_size];
+        _Type* work_buff = allocate_working_buffer< _Type >(src_size, std::nothrow);
 
         if (!work_buff)
             parallel_inplace_merge_sort_hybrid_inner(src, l, r, false, parallelThreshold);
@@ -528,7 +586,7 @@ inline void parallel_preventative_adaptive_inplace_merge_sort_2(_Type* src, size
 #else
             parallel_merge_sort_hybrid_rh_1(src, l, r, work_buff, false);    // stable. Not copying is faster, since std::copy is not parallel - i.e. copying in parallel within the algorithm is faster
 #endif
-            delete[] work_buff;
+            free_working_buffer(work_buff, src_size);
         }
     }
 }
@@ -560,14 +618,14 @@ inline void parallel_linear_in_place_preventative_adaptive_sort(unsigned* src, s
     }
     else
     {
-        unsigned* work_buff = new(std::nothrow) unsigned[src_size];
+        unsigned* work_buff = allocate_working_buffer< unsigned >(src_size, std::nothrow);
 
         if (!work_buff)
             parallel_inplace_merge_sort_hybrid_inner(src, 0, src_size - 1, stable, parallelThreshold);  // not-linear
         else
         {
             parallel_merge_sort_hybrid_radix(src, 0, src_size - 1, work_buff, false, parallelThreshold);  // linear
-            delete[] work_buff;
+            free_working_buffer(work_buff, src_size);
         }
     }
 }
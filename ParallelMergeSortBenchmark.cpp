@@ -11,6 +11,8 @@
 
 #include "ParallelMergeSort.h"
 #include "SortParallel.h"
+#include "RadixSortLsdParallel.h"
+#include "MultiwayMerge.h"
 
 using std::chrono::duration;
 using std::chrono::duration_cast;
@@ -75,6 +77,27 @@ int ParallelMergeSortBenchmark(vector<double>& doubles)
 		print_results("Parallel Merge Sort", sorted, doubles.size(), startTime, endTime);
 	}
 
+	// Parallel LSD Radix Sort of doubles, through their order-preserving unsigned representation
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		for (size_t j = 0; j < doubles.size(); j++) {
+			doublesCopy[ j] = doubles[j];
+			doublesCopy2[j] = doubles[j];
+			sorted[      j] = (double)j;				// page in the working array into system memory
+		}
+		const auto startTime = high_resolution_clock::now();
+		ParallelAlgorithms::SortRadixPar(doublesCopy, sorted, doubles.size());
+		const auto endTime = high_resolution_clock::now();
+
+		sort(std::execution::par_unseq, doublesCopy2, doublesCopy2 + doubles.size());
+		if (!std::equal(doublesCopy, doublesCopy + doubles.size(), doublesCopy2))
+		{
+			std::cout << "Arrays are not equal ";
+			exit(1);
+		}
+		print_results("Parallel LSD Radix Sort", doublesCopy, doubles.size(), startTime, endTime);
+	}
+
 	delete[] sorted;
 	delete[] doublesCopy;
 
@@ -282,3 +305,271 @@ int ParallelMergeBenchmark()
 
 	return 0;
 }
+
+static const char* MergeSimdLevelName(ParallelAlgorithms::MergeSimdLevel level)
+{
+	switch (level)
+	{
+	case ParallelAlgorithms::MergeSimdLevel::Avx512:  return "AVX-512";
+	case ParallelAlgorithms::MergeSimdLevel::Avx2:    return "AVX2";
+	default:                                          return "Scalar";
+	}
+}
+
+// Parallel Merge and Parallel Merge Sort of random keys, using each SIMD merge supported by the CPU for the leaf merges (MergeKernel::Simd, which includes floats and doubles)
+template< class _Type >
+static int ParallelMergeSimdBenchmark(size_t testSize, const char* typeName)
+{
+	std::mt19937_64 generator(42);
+	vector<_Type> keys(testSize);
+	for (auto& k : keys)
+		k = std::is_floating_point< _Type >::value ? (_Type)((double)(long long)generator() / 1e9) : (_Type)generator();
+	vector<_Type> halvesSorted(keys);
+	sort(std::execution::par_unseq, halvesSorted.begin(), halvesSorted.begin() + testSize / 2);
+	sort(std::execution::par_unseq, halvesSorted.begin() + testSize / 2, halvesSorted.end());
+	vector<_Type> sortedReference(keys);
+	sort(std::execution::par_unseq, sortedReference.begin(), sortedReference.end());
+
+	printf("\nBenchmarking Parallel Merge and Parallel Merge Sort with %zu %s (each of %lu bytes)...\n", testSize, typeName, (unsigned long)sizeof(_Type));
+	vector<_Type> work(testSize), dst(testSize);
+	ParallelAlgorithms::MergeSimdLevel supported = ParallelAlgorithms::merge_simd_level_supported();
+
+	for (int level = (int)ParallelAlgorithms::MergeSimdLevel::Scalar; level <= (int)supported; level++)
+	{
+		ParallelAlgorithms::merge_simd_level((ParallelAlgorithms::MergeSimdLevel)level);
+		double mergeTime = 1e9, sortTime = 1e9;
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::merge_parallel_L5(halvesSorted.data(), 0, testSize / 2 - 1, testSize / 2, testSize - 1, dst.data(), 0, 32768, ParallelAlgorithms::MergeKernel::Simd);
+			auto endTime = high_resolution_clock::now();
+			mergeTime = std::min(mergeTime, duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (dst != sortedReference)
+			{
+				printf("Parallel Merge failed: arrays are not equal\n");
+				exit(1);
+			}
+
+			std::copy(keys.begin(), keys.end(), work.begin());
+			startTime = high_resolution_clock::now();
+			ParallelAlgorithms::parallel_merge_sort_hybrid_rh_2(work.data(), 0, testSize - 1, dst.data(), false, true, 32 * 1024, ParallelAlgorithms::MergeKernel::Simd);	// sorted result ends up in dst
+			endTime = high_resolution_clock::now();
+			sortTime = std::min(sortTime, duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (dst != sortedReference)
+			{
+				printf("Parallel Merge Sort failed: arrays are not equal\n");
+				exit(1);
+			}
+		}
+		printf("%-8s merge: Parallel Merge %8.2f ms   Parallel Merge Sort %8.2f ms\n", MergeSimdLevelName((ParallelAlgorithms::MergeSimdLevel)level), mergeTime, sortTime);
+	}
+	ParallelAlgorithms::merge_simd_level(supported);
+	return 0;
+}
+
+int ParallelMergeSimdBenchmark()
+{
+	const size_t testSize = 10'000'000;
+	ParallelMergeSimdBenchmark< unsigned           >(testSize, "unsigned integers");
+	ParallelMergeSimdBenchmark< int                >(testSize, "integers");
+	ParallelMergeSimdBenchmark< float              >(testSize, "floats");
+	ParallelMergeSimdBenchmark< unsigned long long >(testSize, "64-bit unsigned integers");
+	ParallelMergeSimdBenchmark< double             >(testSize, "doubles");
+	return 0;
+}
+
+// Parallel Merge Sort of random keys with each leaf merge kernel
+template< class _Type >
+static int ParallelMergeKernelBenchmark(size_t testSize, const char* typeName)
+{
+	std::mt19937_64 generator(42);
+	vector<_Type> keys(testSize);
+	for (auto& k : keys)
+		k = (_Type)generator();
+	vector<_Type> sortedReference(keys);
+	sort(std::execution::par_unseq, sortedReference.begin(), sortedReference.end());
+
+	printf("\nBenchmarking Parallel Merge Sort leaf merges with %zu %s (each of %lu bytes)...\n", testSize, typeName, (unsigned long)sizeof(_Type));
+	vector<_Type> work(testSize), dst(testSize);
+	const ParallelAlgorithms::MergeKernel kernels[] = { ParallelAlgorithms::MergeKernel::Forward, ParallelAlgorithms::MergeKernel::ForwardUnrolled, ParallelAlgorithms::MergeKernel::Bidirectional };
+	const char* kernelNames[] = { "merge_ptr_1", "merge_ptr_1_unrolled", "merge_ptr_bidirectional" };
+
+	for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		double sortTime = 1e9;
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			std::copy(keys.begin(), keys.end(), work.begin());
+			auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::parallel_merge_sort_hybrid_rh_2(work.data(), 0, testSize - 1, dst.data(), false, true, 32 * 1024, kernels[k]);	// sorted result ends up in dst
+			auto endTime = high_resolution_clock::now();
+			sortTime = std::min(sortTime, duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (dst != sortedReference)
+			{
+				printf("Parallel Merge Sort failed: arrays are not equal\n");
+				exit(1);
+			}
+		}
+		printf("%-24s Parallel Merge Sort %8.2f ms\n", kernelNames[k], sortTime);
+	}
+	return 0;
+}
+
+int ParallelMergeKernelBenchmark()
+{
+	const size_t testSize = 10'000'000;
+	ParallelMergeKernelBenchmark< unsigned  >(testSize, "unsigned integers");		// merge_ptr_1 uses SIMD merge, when supported by the CPU
+	ParallelMergeKernelBenchmark< long long >(testSize, "64-bit integers");
+	return 0;
+}
+
+// Recursive (merge_parallel_L5) vs. merge-path (merge_parallel_path) Parallel Merge of two sorted halves, from small to large arrays
+int ParallelMergePathBenchmark()
+{
+	std::mt19937_64 generator(42);
+	printf("\nBenchmarking recursive vs. merge-path Parallel Merge of unsigned integers (each of %lu bytes)...\n", (unsigned long)sizeof(unsigned));
+
+	for (size_t testSize = 16 * 1024; testSize <= 64 * 1024 * 1024; testSize *= 4)
+	{
+		vector<unsigned> halvesSorted(testSize), dst(testSize);
+		for (auto& k : halvesSorted)
+			k = (unsigned)generator();
+		sort(std::execution::par_unseq, halvesSorted.begin(), halvesSorted.begin() + testSize / 2);
+		sort(std::execution::par_unseq, halvesSorted.begin() + testSize / 2, halvesSorted.end());
+		vector<unsigned> sortedReference(halvesSorted);
+		sort(std::execution::par_unseq, sortedReference.begin(), sortedReference.end());
+		size_t repetitions = std::max((size_t)(64 * 1024 * 1024) / testSize, (size_t)1);	// many merges of small arrays, for measurable time
+
+		double recursiveTime = 1e9, pathTime = 1e9;
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			auto startTime = high_resolution_clock::now();
+			for (size_t r = 0; r < repetitions; r++)
+				ParallelAlgorithms::merge_parallel_L5(halvesSorted.data(), 0, testSize / 2 - 1, testSize / 2, testSize - 1, dst.data(), 0);
+			auto endTime = high_resolution_clock::now();
+			recursiveTime = std::min(recursiveTime, duration_cast<duration<double, milli>>(endTime - startTime).count() / repetitions);
+			if (dst != sortedReference)
+			{
+				printf("Parallel Merge failed: arrays are not equal\n");
+				exit(1);
+			}
+
+			startTime = high_resolution_clock::now();
+			for (size_t r = 0; r < repetitions; r++)
+				ParallelAlgorithms::merge_parallel_path(halvesSorted.data(), halvesSorted.data() + testSize / 2, halvesSorted.data() + testSize / 2, halvesSorted.data() + testSize, dst.data());
+			endTime = high_resolution_clock::now();
+			pathTime = std::min(pathTime, duration_cast<duration<double, milli>>(endTime - startTime).count() / repetitions);
+			if (dst != sortedReference)
+			{
+				printf("Merge-path Parallel Merge failed: arrays are not equal\n");
+				exit(1);
+			}
+		}
+		printf("%10zu elements: recursive %10.4f ms   merge-path %10.4f ms\n", testSize, recursiveTime, pathTime);
+	}
+	return 0;
+}
+
+// Single pass k-way merge (merge_k_way_par) vs. log2(k) passes of pairwise Parallel Merge (merge_parallel_L5) of k sorted runs,
+// of random keys and of low-cardinality keys (e.g. per-shard results of a few categories), which have long blocks of equal keys across the runs
+int ParallelMergeKWayBenchmark()
+{
+	const size_t testSize = 16 * 1024 * 1024;
+	std::mt19937_64 generator(42);
+	printf("\nBenchmarking k-way vs. pairwise Parallel Merge of %zu unsigned integers (each of %lu bytes)...\n", testSize, (unsigned long)sizeof(unsigned));
+
+	for (unsigned numberOfValues : { 0, 16 })		// 0 for random 32-bit keys
+	for (size_t numberOfRuns : { 8, 64, 1024 })
+	{
+		vector<unsigned> runsSorted(testSize), work(testSize), dst(testSize);
+		for (auto& k : runsSorted)
+			k = numberOfValues != 0 ? (unsigned)(generator() % numberOfValues) : (unsigned)generator();
+		vector<size_t> runOffsets(numberOfRuns + 1);
+		for (size_t r = 0; r <= numberOfRuns; r++)
+			runOffsets[r] = r * testSize / numberOfRuns;
+		for (size_t r = 0; r < numberOfRuns; r++)
+			sort(std::execution::par_unseq, runsSorted.begin() + runOffsets[r], runsSorted.begin() + runOffsets[r + 1]);
+		vector<unsigned> sortedReference(runsSorted);
+		sort(std::execution::par_unseq, sortedReference.begin(), sortedReference.end());
+
+		double kWayTime = 1e9, pairwiseTime = 1e9;
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::merge_k_way_par(runsSorted.data(), runOffsets.data(), numberOfRuns, dst.data());
+			auto endTime = high_resolution_clock::now();
+			kWayTime = std::min(kWayTime, duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (dst != sortedReference)
+			{
+				printf("k-way Parallel Merge failed: arrays are not equal\n");
+				exit(1);
+			}
+
+			std::copy(runsSorted.begin(), runsSorted.end(), work.begin());
+			startTime = high_resolution_clock::now();
+			unsigned* src = work.data();
+			unsigned* out = dst.data();
+			for (size_t width = 1; width < numberOfRuns; width *= 2)		// each pass merges pairs of runs, doubling their width
+			{
+				for (size_t r = 0; r < numberOfRuns; r += 2 * width)
+				{
+					size_t l = runOffsets[r], m = runOffsets[std::min(r + width, numberOfRuns)], e = runOffsets[std::min(r + 2 * width, numberOfRuns)];
+					if (m < e)
+						ParallelAlgorithms::merge_parallel_L5(src, l, m - 1, m, e - 1, out, l);
+					else
+						std::copy(src + l, src + e, out + l);
+				}
+				std::swap(src, out);
+			}
+			endTime = high_resolution_clock::now();
+			pairwiseTime = std::min(pairwiseTime, duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (!std::equal(src, src + testSize, sortedReference.begin()))
+			{
+				printf("Pairwise Parallel Merge failed: arrays are not equal\n");
+				exit(1);
+			}
+		}
+		printf("%5zu runs of %-8s keys: k-way %10.2f ms   pairwise %10.2f ms\n", numberOfRuns, numberOfValues != 0 ? "16-value" : "random", kWayTime, pairwiseTime);
+	}
+	return 0;
+}
+
+// Binary tree of merges (parallel_merge_sort_hybrid, parallel_merge_sort_hybrid_radix) vs. a single multiway merge pass (parallel_merge_sort_multiway,
+// parallel_merge_sort_multiway_radix), with one chunk per core and with many cache-sized chunks
+int ParallelMergeSortMultiwayBenchmark()
+{
+	const size_t testSize = 10'000'000;
+	std::mt19937_64 generator(42);
+	vector<unsigned> keys(testSize), work(testSize), dst(testSize);
+	for (auto& k : keys)
+		k = (unsigned)generator();
+	vector<unsigned> sortedReference(keys);
+	sort(std::execution::par_unseq, sortedReference.begin(), sortedReference.end());
+	printf("\nBenchmarking binary tree of merges vs. multiway merge Parallel Merge Sort with %zu unsigned integers (each of %lu bytes)...\n", testSize, (unsigned long)sizeof(unsigned));
+
+	auto benchmark = [&](const char* name, auto sortToDst)
+	{
+		double sortTime = 1e9;
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			std::copy(keys.begin(), keys.end(), work.begin());
+			auto startTime = high_resolution_clock::now();
+			sortToDst();
+			auto endTime = high_resolution_clock::now();
+			sortTime = std::min(sortTime, duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (dst != sortedReference)
+			{
+				printf("%s failed: arrays are not equal\n", name);
+				exit(1);
+			}
+		}
+		printf("%-40s %8.2f ms\n", name, sortTime);
+	};
+	benchmark("merge tree,  std::sort leaves",         [&] { ParallelAlgorithms::parallel_merge_sort_hybrid(work.data(), 0, testSize - 1, dst.data()); });
+	benchmark("multiway,    std::sort chunk per core", [&] { ParallelAlgorithms::parallel_merge_sort_multiway(work.data(), 0, testSize - 1, dst.data(), false); });
+	benchmark("multiway,    std::sort 64 chunks",      [&] { ParallelAlgorithms::parallel_merge_sort_multiway(work.data(), 0, testSize - 1, dst.data(), false, true, 64); });
+	benchmark("merge tree,  radix leaves",             [&] { ParallelAlgorithms::parallel_merge_sort_hybrid_radix(work.data(), 0, testSize - 1, dst.data()); });
+	benchmark("multiway,    radix chunk per core",     [&] { ParallelAlgorithms::parallel_merge_sort_multiway_radix(work.data(), 0, testSize - 1, dst.data()); });
+	benchmark("multiway,    radix 64 chunks",          [&] { ParallelAlgorithms::parallel_merge_sort_multiway_radix(work.data(), 0, testSize - 1, dst.data(), true, 64); });
+	return 0;
+}
@@ -4,6 +4,10 @@
 #ifndef _RadixSortCommon_h
 #define _RadixSortCommon_h
 
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
 // A set of logical right shift functions to work-around the C++ issue of performing an arithmetic right shift
 // for >>= operation on signed types.
 inline char logicalRightShift( char a, unsigned long shiftAmount )
@@ -59,13 +63,97 @@ inline unsigned extractDigit_1(_Type a, _Type bitMask, unsigned shiftRightAmount
 {
 	unsigned digit = (unsigned)((a >> shiftRightAmount) & bitMask);	// extract the digit we are sorting based on
 	return digit;
-}template< unsigned long PowerOfTwoRadix, class _Type >
+}
+// Extracts the most significant digit of a signed integer, with its sign bit flipped, so that negative values sort before positive values
+template< unsigned long PowerOfTwoRadix, class _Type >
 inline unsigned long extractDigitNegate( _Type a, _Type bitMask, unsigned long shiftRightAmount )
 {
-	unsigned long digit = (unsigned long)logicalRightShift_ru((_Type)( a & bitMask ), shiftRightAmount );	// extract the digit we are sorting based on
+	typedef typename std::make_unsigned< _Type >::type _UnsignedType;
+	unsigned long digit = (unsigned long)((_UnsignedType)( a & bitMask ) >> shiftRightAmount );	// logical right shift, even for signed types
 	digit ^= ( PowerOfTwoRadix >> 1 );
 	return digit;
 }
+// Order-preserving bit transforms, which map signed integer and IEEE-754 floating-point keys onto unsigned keys of the same size,
+// so that sorting the unsigned keys orders the original keys. Radix Sorts operate on the unsigned representation of the array,
+// applying these transforms on the fly inside the first histogram and the last permutation passes, without extra passes over the array.
+//   unsigned       - identity
+//   signed         - flip the sign bit, which only changes the most significant digit (same as extractDigitNegate)
+//   floating-point - flip the sign bit of positive values and all of the bits of negative values: -NaN < -Inf < -0.0 < +0.0 < +Inf < +NaN
+template< class _Type, class Enable = void >
+struct RadixKeyTransform;
+
+template< class _Type >
+struct RadixKeyTransform< _Type, typename std::enable_if< std::is_unsigned< _Type >::value >::type >
+{
+	typedef _Type UnsignedType;
+	static constexpr bool NegatesTopDigit = false;
+	static constexpr bool TransformsBits  = false;
+	static UnsignedType to_unsigned(  UnsignedType a ) { return a; }
+	static UnsignedType from_unsigned(UnsignedType a ) { return a; }
+};
+
+template< class _Type >
+struct RadixKeyTransform< _Type, typename std::enable_if< std::is_integral< _Type >::value && std::is_signed< _Type >::value >::type >
+{
+	typedef typename std::make_unsigned< _Type >::type UnsignedType;
+	static constexpr UnsignedType SignBit = (UnsignedType)((UnsignedType)1 << (sizeof(UnsignedType) * 8 - 1));
+	static constexpr bool NegatesTopDigit = true;
+	static constexpr bool TransformsBits  = false;
+	static UnsignedType to_unsigned(  UnsignedType a ) { return (UnsignedType)(a ^ SignBit); }
+	static UnsignedType from_unsigned(UnsignedType a ) { return (UnsignedType)(a ^ SignBit); }
+};
+
+template< class _Type >
+struct RadixKeyTransform< _Type, typename std::enable_if< std::is_floating_point< _Type >::value >::type >
+{
+	static_assert(sizeof(_Type) == 4 || sizeof(_Type) == 8, "RadixKeyTransform: only 32-bit float and 64-bit double keys are supported");
+	typedef typename std::conditional< sizeof(_Type) == 4, uint32_t, uint64_t >::type UnsignedType;
+	static constexpr unsigned     SignShift = sizeof(UnsignedType) * 8 - 1;
+	static constexpr UnsignedType SignBit   = (UnsignedType)1 << SignShift;
+	static constexpr bool NegatesTopDigit = false;
+	static constexpr bool TransformsBits  = true;
+	static UnsignedType to_unsigned(  UnsignedType a ) { return a ^ ((UnsignedType)(0 - (a >> SignShift)) | SignBit); }
+	static UnsignedType from_unsigned(UnsignedType a ) { return a ^ ((UnsignedType)((a >> SignShift) - 1)  | SignBit); }
+};
+
+// Order-preserving unsigned representation of a key of any type supported by RadixKeyTransform (e.g. a key projected out of a record)
+template< class _Type >
+inline typename RadixKeyTransform< _Type >::UnsignedType radix_key_to_unsigned( _Type key )
+{
+	typename RadixKeyTransform< _Type >::UnsignedType a;
+	memcpy(&a, &key, sizeof(a));
+	return RadixKeyTransform< _Type >::to_unsigned(a);
+}
+
+// Key accessors for a single digit pass of a Radix Sort: key_in is applied to each key read, before its digit is extracted,
+// and key_out to the result of key_in before it is written. Unsigned keys, and the middle passes of all keys, use the identity.
+struct RadixKeyIdentity
+{
+	template< class _UnsignedType > static _UnsignedType key_in( _UnsignedType a ) { return a; }
+	template< class _UnsignedType > static _UnsignedType key_out(_UnsignedType a ) { return a; }
+};
+
+// LSD Radix Sort passes: floating-point keys are transformed on the way in during the first pass and back on the way out during the last pass.
+// Signed integer keys are transformed in and back out during the last pass, which only flips the sign bit of the top digit and leaves the keys unchanged.
+template< class _KeyTransform, bool FirstDigit, bool LastDigit >
+struct RadixKeyPass
+{
+	typedef typename _KeyTransform::UnsignedType UnsignedType;
+	static constexpr bool TransformIn  = (FirstDigit && _KeyTransform::TransformsBits) || (LastDigit && _KeyTransform::NegatesTopDigit);
+	static constexpr bool TransformOut = LastDigit && (_KeyTransform::TransformsBits || _KeyTransform::NegatesTopDigit);
+	static UnsignedType key_in( UnsignedType a ) { return TransformIn  ? _KeyTransform::to_unsigned(  a ) : a; }
+	static UnsignedType key_out(UnsignedType a ) { return TransformOut ? _KeyTransform::from_unsigned(a ) : a; }
+};
+
+// Statistics of LSD Radix Sorts, which accumulate across sorts so they can be aggregated in production.
+// A digit pass is skipped when all elements have the same value of that digit (e.g. small-range IDs, or timestamps with constant high bytes).
+struct RadixSortStats
+{
+	size_t numberOfDigits        = 0;	// digits of all keys sorted, including skipped ones
+	size_t numberOfPassesSkipped = 0;	// digit passes skipped, since the permutation would have left the array unchanged
+	size_t numberOfCopyBacks     = 0;	// sorts that had to copy the result back from the working buffer, due to an odd number of passes
+};
+
 // Shifts either left or right based on the sign of the shiftAmount argument.  Positive values shift left by that many bits,
 // zero does not shift at all, and negative values shift right by that many bits.
 template< class _Type >
@@ -534,6 +534,78 @@ inline void RadixSortLSDPowerOf2Radix_unsigned_TwoPhase(unsigned* a, unsigned* b
 	}
 }
 
+// Permutation phase of one digit of LSD Radix Sort, with _KeyPass transforming signed and floating-point keys on the way in and out (see RadixKeyPass)
+template< unsigned long PowerOfTwoRadix, class _KeyPass, class _UnsignedType >
+inline void _RadixSortLSD_StableUnsigned_PowerOf2RadixScalar_PermuteKeyPass(const _UnsignedType* input_array, _UnsignedType* output_array, size_t last, unsigned long shiftRightAmount, size_t* endOfBin)
+{
+	const _UnsignedType bit_mask = PowerOfTwoRadix - 1;
+	for (size_t _current = 0; _current <= last; _current++)
+	{
+		_UnsignedType key = _KeyPass::key_in(input_array[_current]);
+		output_array[endOfBin[(key >> shiftRightAmount) & bit_mask]++] = _KeyPass::key_out(key);
+	}
+}
+
+// Serial LSD Radix Sort, with Counting separated into its own phase, followed by a permutation phase, for unsigned, signed integer and floating-point keys.
+// The single counting pass counts the digits of the transformed keys (see RadixKeyTransform). The first permutation pass transforms the keys as it reads them,
+// and the last permutation pass transforms them back as it writes them, so no extra passes over the array are needed.
+// Even number of digits (32-bit and 64-bit keys) leaves the result in input_array
+template< class _KeyTransform >
+inline void _RadixSortLSD_StableKeyTransform_PowerOf2RadixScalar_TwoPhase(typename _KeyTransform::UnsignedType* input_array, typename _KeyTransform::UnsignedType* output_array, size_t last)
+{
+	typedef typename _KeyTransform::UnsignedType _UnsignedType;
+	const unsigned BitsPerDigit = 8;
+	const size_t NumberOfBins = 1 << BitsPerDigit;
+	const unsigned NumberOfDigits = sizeof(_UnsignedType);
+	const _UnsignedType bit_mask = NumberOfBins - 1;
+	_UnsignedType* _input_array  = input_array;
+	_UnsignedType* _output_array = output_array;
+
+	size_t* count2D = new size_t[NumberOfDigits * NumberOfBins]{};
+	for (size_t _current = 0; _current <= last; _current++)		// counting phase of all digits at once
+	{
+		_UnsignedType value = _KeyTransform::to_unsigned(_input_array[_current]);
+		for (unsigned d = 0; d < NumberOfDigits; d++)
+			count2D[d * NumberOfBins + ((value >> (d * BitsPerDigit)) & bit_mask)]++;
+	}
+
+	for (unsigned currentDigit = 0; currentDigit < NumberOfDigits; currentDigit++)
+	{
+		size_t* count = count2D + (currentDigit * NumberOfBins);
+		alignas(64) size_t endOfBin[NumberOfBins];
+		endOfBin[0] = 0;
+		for (size_t i = 1; i < NumberOfBins; i++)
+			endOfBin[i] = endOfBin[i - 1] + count[i - 1];
+
+		unsigned long shiftRightAmount = currentDigit * BitsPerDigit;
+		if (currentDigit == 0)
+			_RadixSortLSD_StableUnsigned_PowerOf2RadixScalar_PermuteKeyPass< NumberOfBins, RadixKeyPass< _KeyTransform, true, false > >(_input_array, _output_array, last, shiftRightAmount, endOfBin);
+		else if (currentDigit == NumberOfDigits - 1)
+			_RadixSortLSD_StableUnsigned_PowerOf2RadixScalar_PermuteKeyPass< NumberOfBins, RadixKeyPass< _KeyTransform, false, true > >(_input_array, _output_array, last, shiftRightAmount, endOfBin);
+		else
+			_RadixSortLSD_StableUnsigned_PowerOf2RadixScalar_PermuteKeyPass< NumberOfBins, RadixKeyIdentity >(_input_array, _output_array, last, shiftRightAmount, endOfBin);
+
+		std::swap(_input_array, _output_array);
+	}
+	delete[] count2D;
+}
+
+// LSD Radix Sort of 32-bit and 64-bit unsigned, signed integer (int32/int64) and floating-point (float/double) keys - stable
+// Result is returned in "a", whereas "b" is used a temporary working buffer.
+template< class _Type >
+inline void RadixSortLSDPowerOf2Radix_TwoPhase(_Type* a, _Type* b, size_t a_size)
+{
+	static_assert(sizeof(_Type) == 4 || sizeof(_Type) == 8, "RadixSortLSDPowerOf2Radix_TwoPhase: only 32-bit and 64-bit keys are supported");
+	typedef RadixKeyTransform< _Type > _KeyTransform;
+	typedef typename _KeyTransform::UnsignedType _UnsignedType;
+	const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+
+	if (a_size >= Threshold)
+		_RadixSortLSD_StableKeyTransform_PowerOf2RadixScalar_TwoPhase< _KeyTransform >((_UnsignedType*)a, (_UnsignedType*)b, a_size - 1);
+	else
+		insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+}
+
 // Permute phase of LSD Radix Sort with de-randomized write memory accesses
 // Derandomizes system memory accesses by buffering all Radix bin accesses, turning 256-bin random memory writes into sequential writes
 // Also implements an optimization for constant arrays, which avoids loop dependency of incrementing through memory/array access.
@@ -629,8 +701,10 @@ inline void _RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomized(unsig
 
 // Derandomizes system memory accesses by buffering all Radix bin accesses, turning 256-bin random memory writes into sequential writes
 // Parallel LSD Radix Sort, with Counting separated into its own parallel phase, followed by a serial permutation phase, as is done in HPCsharp in C#
+// Digits with all elements in a single bin are skipped, and the result is always left in input_array
 template< unsigned BitsPerDigit >
-void _RadixSortLSD_StableUnsigned_PowerOf2Radix_TwoPhase_DeRandomize(unsigned* input_array, unsigned* output_array, size_t last, unsigned bitMask, unsigned long shiftRightAmount)
+void _RadixSortLSD_StableUnsigned_PowerOf2Radix_TwoPhase_DeRandomize(unsigned* input_array, unsigned* output_array, size_t last, unsigned bitMask, unsigned long shiftRightAmount,
+	RadixSortStats* stats = NULL)
 {
 	const size_t NumberOfBins = 1 << BitsPerDigit;
 	unsigned* _input_array  = input_array;
@@ -650,10 +724,28 @@ void _RadixSortLSD_StableUnsigned_PowerOf2Radix_TwoPhase_DeRandomize(unsigned* i
 	//const auto endTime = high_resolution_clock::now();
 	//print_results("Histogram: ", startTime, endTime);
 
+	size_t numberOfPassesSkipped = 0;
+
 	while (bitMask != 0)						// end processing digits when all the mask bits have been processes and shift out, leaving none
 	{
 		size_t* count = count2D + (currentDigit * NumberOfBins);
 
+		bool trivialDigit = false;				// all elements have the same digit, and permuting would leave the array unchanged
+		for (size_t i = 0; i < NumberOfBins; i++)
+			if (count[i] != 0)
+			{
+				trivialDigit = count[i] == last + 1;
+				break;
+			}
+		if (trivialDigit)
+		{
+			numberOfPassesSkipped++;
+			bitMask <<= BitsPerDigit;
+			shiftRightAmount += BitsPerDigit;
+			currentDigit++;
+			continue;
+		}
+
 		size_t startOfBin[NumberOfBins], endOfBin[NumberOfBins];
 		startOfBin[0] = endOfBin[0] = 0;
 		for (size_t i = 1; i < NumberOfBins; i++)
@@ -672,6 +764,15 @@ void _RadixSortLSD_StableUnsigned_PowerOf2Radix_TwoPhase_DeRandomize(unsigned* i
 		std::swap(_input_array, _output_array);
 		currentDigit++;
 	}
+	if (_output_array_has_result)				// odd number of passes, due to skipped digits
+		memcpy(input_array, _input_array, (last + 1) * sizeof(unsigned));
+
+	if (stats != NULL)
+	{
+		stats->numberOfDigits        += currentDigit;
+		stats->numberOfPassesSkipped += numberOfPassesSkipped;
+		stats->numberOfCopyBacks     += _output_array_has_result ? 1 : 0;
+	}
 
 	delete[] count2D;
 #if 1
@@ -749,7 +850,7 @@ inline void _RadixSortLSD_StableUnsigned_Nbits_TwoPhase_DeRandomize(unsigned* in
 
 // LSD Radix Sort - stable (LSD has to be, and this may preclude LSD Radix from being able to be in-place)
 //template< unsigned Threshold = 100 >
-inline void RadixSortLSDPowerOf2Radix_unsigned_TwoPhase_DeRandomize(unsigned* a, unsigned* b, size_t a_size)
+inline void RadixSortLSDPowerOf2Radix_unsigned_TwoPhase_DeRandomize(unsigned* a, unsigned* b, size_t a_size, RadixSortStats* stats)
 {
 	const unsigned Threshold = 100;	// Threshold of when to switch to using Insertion Sort
 	const unsigned BitsPerDigit = 8;
@@ -761,7 +862,7 @@ inline void RadixSortLSDPowerOf2Radix_unsigned_TwoPhase_DeRandomize(unsigned* a,
 	// The beauty of using template arguments instead of function parameters for the Threshold and Log2ofPowerOfTwoRadix is
 	// they are not pushed on the stack and are treated as constants, but local.
 	if (a_size >= Threshold) {
-		_RadixSortLSD_StableUnsigned_PowerOf2Radix_TwoPhase_DeRandomize< BitsPerDigit >(a, b, a_size - 1, bitMask, shiftRightAmount);
+		_RadixSortLSD_StableUnsigned_PowerOf2Radix_TwoPhase_DeRandomize< BitsPerDigit >(a, b, a_size - 1, bitMask, shiftRightAmount, stats);
 	}
 	else {
 		// TODO: Substitute Merge Sort, as it will get rid off the for loop, since it's internal to MergeSort
@@ -771,6 +872,11 @@ inline void RadixSortLSDPowerOf2Radix_unsigned_TwoPhase_DeRandomize(unsigned* a,
 	}
 }
 
+inline void RadixSortLSDPowerOf2Radix_unsigned_TwoPhase_DeRandomize(unsigned* a, unsigned* b, size_t a_size)
+{
+	RadixSortLSDPowerOf2Radix_unsigned_TwoPhase_DeRandomize(a, b, a_size, NULL);
+}
+
 // LSD Radix Sort - stable (LSD has to be, and this may preclude LSD Radix from being able to be in-place)
 template< unsigned BitsPerDigit = 8, unsigned Threshold = 100 >
 inline void RadixSortLSDPowerOf2Radix_Nbit_TwoPhase_DeRandomize(unsigned* a, unsigned* b, size_t a_size)
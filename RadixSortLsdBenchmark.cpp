@@ -10,6 +10,15 @@
 
 #include "RadixSortLSD.h"
 #include "RadixSortLsdParallel.h"
+#include "LargePageAllocator.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#endif
 
 using std::chrono::duration;
 using std::chrono::duration_cast;
@@ -112,3 +121,466 @@ int ParallelRadixSortLsdBenchmark(vector<unsigned>& uints)
 
 	return 0;
 }
+
+static void print_results(const char* const tag, const unsigned long long* sorted, size_t sortedLength,
+	high_resolution_clock::time_point startTime,
+	high_resolution_clock::time_point endTime) {
+	printf("%s: Lowest: %llu Highest: %llu Time: %fms\n", tag,
+		sorted[0], sorted[sortedLength - 1],
+		duration_cast<duration<double, milli>>(endTime - startTime).count());
+}
+
+// Compares Parallel LSD Radix Sort of 64-bit keys against Parallel Merge Sort, on 100 million and 1 billion random keys
+int ParallelRadixSortLsdBenchmark64()
+{
+	const size_t testSizes[] = { 100'000'000, 1'000'000'000 };
+	std::mt19937_64 dist(1234);
+
+	for (size_t testSize : testSizes)
+	{
+		printf("\nBenchmarking Parallel Radix Sort LSD and Parallel Merge Sort with %zu random 64-bit unsigned integers...\n\n", testSize);
+		vector<unsigned long long> u64s(testSize);
+		for (auto& d : u64s)
+			d = static_cast<unsigned long long>(dist());
+		vector<unsigned long long> u64sCopy(   testSize);
+		vector<unsigned long long> tmp_working(testSize);
+
+		vector<unsigned long long> sorted_reference(u64s);
+		sort(std::execution::par_unseq, sorted_reference.begin(), sorted_reference.end());
+
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			for (size_t j = 0; j < testSize; j++) {
+				u64sCopy[   j] = u64s[j];
+				tmp_working[j] = (unsigned long long)j;		// page in the destination array into system memory
+			}
+			auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::SortRadixPar(u64sCopy.data(), tmp_working.data(), testSize);
+			auto endTime = high_resolution_clock::now();
+			print_results("Parallel Radix Sort LSD (64-bit)", u64sCopy.data(), testSize, startTime, endTime);
+			if (!std::equal(sorted_reference.begin(), sorted_reference.end(), u64sCopy.begin()))
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+
+			for (size_t j = 0; j < testSize; j++)
+				u64sCopy[j] = u64s[j];
+			startTime = high_resolution_clock::now();
+			ParallelAlgorithms::parallel_merge_sort_hybrid(u64sCopy.data(), (size_t)0, testSize - 1, tmp_working.data(), false);	// result ends up in u64sCopy
+			endTime = high_resolution_clock::now();
+			print_results("Parallel Merge Sort     (64-bit)", u64sCopy.data(), testSize, startTime, endTime);
+			if (!std::equal(sorted_reference.begin(), sorted_reference.end(), u64sCopy.begin()))
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+		}
+	}
+
+	return 0;
+}
+
+// Records of 16 and 64 bytes, sorted by a 64-bit timestamp key
+struct Trade16
+{
+	unsigned long long ts;
+	unsigned           id;
+	float              price;
+};
+
+struct Trade64
+{
+	unsigned long long ts;
+	unsigned long long id;
+	double             fields[6];
+};
+
+template< class _Record >
+static int ParallelRadixSortLsdRecordsBenchmark(size_t testSize)
+{
+	printf("\nBenchmarking Parallel Radix Sort LSD of %zu-byte records and Parallel Stable Sort with %zu random records...\n\n", sizeof(_Record), testSize);
+	std::mt19937_64 dist(1234);
+	vector<_Record> records(testSize);
+	for (size_t j = 0; j < testSize; j++)
+	{
+		records[j]    = _Record{};
+		records[j].ts = static_cast<unsigned long long>(dist());
+		records[j].id = (unsigned)j;
+	}
+	vector<_Record> recordsCopy(testSize);
+	vector<_Record> tmp_working(testSize);
+	auto getKey  = [](const _Record& r) { return r.ts; };
+	auto compare = [](const _Record& a, const _Record& b) { return a.ts < b.ts; };
+
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		for (size_t j = 0; j < testSize; j++) {
+			recordsCopy[j] = records[j];
+			tmp_working[j] = records[j];		// page in the destination array into system memory
+		}
+		auto startTime = high_resolution_clock::now();
+		ParallelAlgorithms::SortRadixRecordsPar(recordsCopy.data(), tmp_working.data(), testSize, getKey);
+		auto endTime = high_resolution_clock::now();
+		printf("Parallel Radix Sort LSD (records): Time: %fms\n", duration_cast<duration<double, milli>>(endTime - startTime).count());
+
+		vector<_Record> sorted_reference(records);
+		startTime = high_resolution_clock::now();
+		std::stable_sort(std::execution::par_unseq, sorted_reference.begin(), sorted_reference.end(), compare);
+		endTime = high_resolution_clock::now();
+		printf("Parallel Stable Sort    (records): Time: %fms\n", duration_cast<duration<double, milli>>(endTime - startTime).count());
+
+		for (size_t j = 0; j < testSize; j++)
+		{
+			if (recordsCopy[j].ts != sorted_reference[j].ts || recordsCopy[j].id != sorted_reference[j].id)
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+		}
+	}
+	return 0;
+}
+
+int ParallelRadixSortLsdRecordsBenchmark()
+{
+	ParallelRadixSortLsdRecordsBenchmark< Trade16 >(100'000'000);
+	ParallelRadixSortLsdRecordsBenchmark< Trade64 >( 25'000'000);
+	return 0;
+}
+
+// Many medium size arrays sorted one after another, with and without a reusable RadixSortWorkspace
+int ParallelRadixSortLsdWorkspaceBenchmark()
+{
+	const size_t arraySize      = 1'000'000;
+	const size_t numberOfArrays = 200;
+	std::mt19937 dist(1234);
+
+	printf("\nBenchmarking Parallel Radix Sort LSD of %zu arrays of %zu random 32-bit unsigned integers, with and without a workspace...\n\n", numberOfArrays, arraySize);
+	vector<unsigned> uints(arraySize * numberOfArrays);
+	for (auto& d : uints)
+		d = static_cast<unsigned>(dist());
+	vector<unsigned> uintsCopy(uints.size());
+	vector<unsigned> values(uints.size());		// values of the key-value sort, which are permuted along with the keys
+
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		std::copy(uints.begin(), uints.end(), uintsCopy.begin());
+		auto startTime = high_resolution_clock::now();
+		for (size_t k = 0; k < numberOfArrays; k++)
+			ParallelAlgorithms::SortRadixPar(uintsCopy.data() + k * arraySize, arraySize);
+		auto endTime = high_resolution_clock::now();
+		printf("Parallel Radix Sort LSD, allocating every call: %.2f ms\n", duration_cast<duration<double, milli>>(endTime - startTime).count());
+
+		std::copy(uints.begin(), uints.end(), uintsCopy.begin());
+		ParallelAlgorithms::RadixSortWorkspace workspace;
+		startTime = high_resolution_clock::now();
+		for (size_t k = 0; k < numberOfArrays; k++)
+			ParallelAlgorithms::SortRadixPar(uintsCopy.data() + k * arraySize, arraySize, workspace);
+		endTime = high_resolution_clock::now();
+		printf("Parallel Radix Sort LSD, reusing a workspace:   %.2f ms\n", duration_cast<duration<double, milli>>(endTime - startTime).count());
+
+		for (size_t k = 0; k < numberOfArrays; k++)
+			if (!std::is_sorted(uintsCopy.begin() + k * arraySize, uintsCopy.begin() + (k + 1) * arraySize))
+			{
+				printf("Array is not sorted\n");
+				exit(1);
+			}
+
+		std::copy(uints.begin(), uints.end(), uintsCopy.begin());
+		startTime = high_resolution_clock::now();
+		for (size_t k = 0; k < numberOfArrays; k++)
+			ParallelAlgorithms::SortRadixByKeyPar(uintsCopy.data() + k * arraySize, values.data() + k * arraySize, arraySize);
+		endTime = high_resolution_clock::now();
+		printf("Parallel Radix Sort LSD by key, allocating every call: %.2f ms\n", duration_cast<duration<double, milli>>(endTime - startTime).count());
+
+		std::copy(uints.begin(), uints.end(), uintsCopy.begin());
+		startTime = high_resolution_clock::now();
+		for (size_t k = 0; k < numberOfArrays; k++)
+			ParallelAlgorithms::SortRadixByKeyPar(uintsCopy.data() + k * arraySize, values.data() + k * arraySize, arraySize, workspace);
+		endTime = high_resolution_clock::now();
+		printf("Parallel Radix Sort LSD by key, reusing a workspace:   %.2f ms\n", duration_cast<duration<double, milli>>(endTime - startTime).count());
+
+		for (size_t k = 0; k < numberOfArrays; k++)
+			if (!std::is_sorted(uintsCopy.begin() + k * arraySize, uintsCopy.begin() + (k + 1) * arraySize))
+			{
+				printf("Array is not sorted by key\n");
+				exit(1);
+			}
+	}
+	return 0;
+}
+
+// Arrays much larger than the last level cache, with de-randomization buffers flushed by memcpy vs. non-temporal (streaming) stores
+template< class _Type >
+static int ParallelRadixSortLsdStreamingStoresBenchmark(size_t testSize)
+{
+	std::mt19937_64 dist(1234);
+
+	printf("\nBenchmarking Parallel Radix Sort LSD with %zu random %zu-bit unsigned integers, flushing with memcpy vs. streaming stores...\n\n", testSize, sizeof(_Type) * 8);
+	vector<_Type> keys(testSize);
+	for (auto& d : keys)
+		d = static_cast<_Type>(dist());
+	vector<_Type> keysCopy(testSize);
+	vector<_Type> sorted_reference(keys);
+	sort(std::execution::par_unseq, sorted_reference.begin(), sorted_reference.end());
+
+	ParallelAlgorithms::RadixSortWorkspace workspace;
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		for (bool streamingStores : { false, true })
+		{
+			std::copy(keys.begin(), keys.end(), keysCopy.begin());
+			workspace.streaming_stores(streamingStores);
+			auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::SortRadixPar(keysCopy.data(), testSize, workspace);
+			auto endTime = high_resolution_clock::now();
+			printf("Parallel Radix Sort LSD, %s: %.2f ms\n", streamingStores ? "streaming stores" : "memcpy          ", duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (!std::equal(sorted_reference.begin(), sorted_reference.end(), keysCopy.begin()))
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+		}
+	}
+	return 0;
+}
+
+int ParallelRadixSortLsdStreamingStoresBenchmark()
+{
+	ParallelRadixSortLsdStreamingStoresBenchmark< unsigned           >(250'000'000);
+	ParallelRadixSortLsdStreamingStoresBenchmark< unsigned long long >(125'000'000);
+	return 0;
+}
+
+// 8-bit digits vs. 11-bit digits vs. the digit width selected from the cache sizes of this machine
+template< class _Type >
+static int ParallelRadixSortLsdNbitBenchmark(size_t testSize)
+{
+	std::mt19937_64 dist(1234);
+
+	printf("\nBenchmarking Parallel Radix Sort LSD with %zu random %zu-bit unsigned integers, with 8-bit, 11-bit and auto-selected digits...\n\n", testSize, sizeof(_Type) * 8);
+	vector<_Type> keys(testSize);
+	for (auto& d : keys)
+		d = static_cast<_Type>(dist());
+	vector<_Type> keysCopy(testSize);
+	vector<_Type> sorted_reference(keys);
+	sort(std::execution::par_unseq, sorted_reference.begin(), sorted_reference.end());
+
+	ParallelAlgorithms::RadixSortWorkspace workspace;
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		for (unsigned digitBits : { 8, 11, 0 })
+		{
+			std::copy(keys.begin(), keys.end(), keysCopy.begin());
+			auto startTime = high_resolution_clock::now();
+			if (digitBits == 8)
+				ParallelAlgorithms::SortRadixNbitPar< 8 >(keysCopy.data(), testSize, workspace);
+			else if (digitBits == 11)
+				ParallelAlgorithms::SortRadixNbitPar< 11 >(keysCopy.data(), testSize, workspace);
+			else
+				ParallelAlgorithms::SortRadixNbitPar(keysCopy.data(), testSize, workspace);
+			auto endTime = high_resolution_clock::now();
+			if (digitBits != 0)
+				printf("Parallel Radix Sort LSD, %2u-bit digits: %.2f ms\n", digitBits, duration_cast<duration<double, milli>>(endTime - startTime).count());
+			else
+				printf("Parallel Radix Sort LSD, auto (%2u-bit): %.2f ms\n", ParallelAlgorithms::SelectRadixDigitBits(sizeof(_Type), ParallelAlgorithms::_SortRadixParWorkQuantum(testSize, 64 * 1024)),
+					duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (!std::equal(sorted_reference.begin(), sorted_reference.end(), keysCopy.begin()))
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+		}
+	}
+	return 0;
+}
+
+int ParallelRadixSortLsdNbitBenchmark()
+{
+	ParallelRadixSortLsdNbitBenchmark< unsigned           >(100'000'000);
+	ParallelRadixSortLsdNbitBenchmark< unsigned long long >( 50'000'000);
+	return 0;
+}
+
+// NUMA mode vs. the default task scheduling. On a single-node machine, numberOfSimulatedNodes splits the cores into simulated nodes,
+// which measures the overhead of the NUMA mode, whereas gains from local memory need a multi-socket machine.
+int ParallelRadixSortLsdNumaBenchmark(unsigned numberOfSimulatedNodes)
+{
+	const size_t testSize = 100'000'000;
+	std::mt19937 dist(1234);
+
+	ParallelAlgorithms::NumaTaskArenas numaArenas(numberOfSimulatedNodes);
+	printf("\nBenchmarking Parallel Radix Sort LSD with %zu random 32-bit unsigned integers, without and with NUMA mode of %zu nodes...\n\n", testSize, numaArenas.number_of_nodes());
+	vector<unsigned> uints(testSize);
+	for (auto& d : uints)
+		d = static_cast<unsigned>(dist());
+	vector<unsigned> uintsCopy(testSize);
+
+	ParallelAlgorithms::RadixSortWorkspace workspace;
+	ParallelAlgorithms::RadixSortWorkspace numaWorkspace;
+	numaWorkspace.numa_arenas(&numaArenas);
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		for (bool numa : { false, true })
+		{
+			std::copy(uints.begin(), uints.end(), uintsCopy.begin());
+			auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::SortRadixPar(uintsCopy.data(), testSize, numa ? numaWorkspace : workspace);
+			auto endTime = high_resolution_clock::now();
+			printf("Parallel Radix Sort LSD, %s: %.2f ms\n", numa ? "NUMA mode" : "default  ", duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (!std::is_sorted(uintsCopy.begin(), uintsCopy.end()))
+			{
+				printf("Array is not sorted\n");
+				exit(1);
+			}
+		}
+	}
+	return 0;
+}
+
+// Counts data TLB load misses of this process, using Linux perf events. Not available on other operating systems, nor in most virtual machines.
+class DataTlbMissCounter
+{
+public:
+	DataTlbMissCounter()
+	{
+#if defined(__linux__)
+		perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size           = sizeof(attributes);
+		attributes.type           = PERF_TYPE_HW_CACHE;
+		attributes.config         = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attributes.disabled       = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv     = 1;
+		attributes.inherit        = 1;		// include worker threads created after this point
+		m_fd = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+	}
+	~DataTlbMissCounter()
+	{
+#if defined(__linux__)
+		if (m_fd >= 0)
+			close(m_fd);
+#endif
+	}
+	bool available() const { return m_fd >= 0; }
+	void start()
+	{
+#if defined(__linux__)
+		if (m_fd >= 0)
+		{
+			ioctl(m_fd, PERF_EVENT_IOC_RESET,  0);
+			ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+	unsigned long long stop()
+	{
+		unsigned long long count = 0;
+#if defined(__linux__)
+		if (m_fd >= 0)
+		{
+			ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+				count = 0;
+		}
+#endif
+		return count;
+	}
+private:
+	int m_fd = -1;
+};
+
+// Regular 4 KB pages vs. 2 MB large pages, for both the array being sorted and the working buffer, which LSD Radix Sort permutes randomly between
+// explicitHugePages uses huge pages reserved in the hugetlbfs pool (e.g. echo 512 > /proc/sys/vm/nr_hugepages), instead of transparent huge pages
+int ParallelRadixSortLsdLargePagesBenchmark(bool explicitHugePages)
+{
+	const size_t testSize = 100'000'000;
+	std::mt19937 dist(1234);
+	ParallelAlgorithms::LargePageMode defaultLargePageMode = ParallelAlgorithms::large_page_mode();
+	ParallelAlgorithms::LargePageMode largePageMode = explicitHugePages ? ParallelAlgorithms::LargePageMode::Explicit : ParallelAlgorithms::LargePageMode::Transparent;
+
+	printf("\nBenchmarking Parallel Radix Sort LSD with %zu random 32-bit unsigned integers, with 4 KB pages vs. 2 MB pages...\n\n", testSize);
+	vector<unsigned> uints(testSize);
+	for (auto& d : uints)
+		d = static_cast<unsigned>(dist());
+
+	DataTlbMissCounter tlbMisses;
+	if (!tlbMisses.available())
+		printf("Data TLB miss counter is not available (needs Linux perf events on bare metal, and perf_event_paranoid <= 2)\n");
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		for (ParallelAlgorithms::LargePageMode mode : { ParallelAlgorithms::LargePageMode::Off, largePageMode })
+		{
+			ParallelAlgorithms::large_page_mode(mode);
+			unsigned* uintsCopy = ParallelAlgorithms::allocate_working_buffer< unsigned >(testSize);
+			std::copy(uints.begin(), uints.end(), uintsCopy);
+
+			tlbMisses.start();
+			auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::SortRadixPar(uintsCopy, testSize);
+			auto endTime = high_resolution_clock::now();
+			unsigned long long misses = tlbMisses.stop();
+			printf("Parallel Radix Sort LSD, %s pages: %.2f ms", mode == ParallelAlgorithms::LargePageMode::Off ? "4 KB" : "2 MB", duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (tlbMisses.available())
+				printf("   data TLB load misses: %llu", misses);
+			printf("\n");
+			if (!std::is_sorted(uintsCopy, uintsCopy + testSize))
+			{
+				printf("Array is not sorted\n");
+				exit(1);
+			}
+			ParallelAlgorithms::free_working_buffer(uintsCopy, testSize);
+		}
+	}
+	ParallelAlgorithms::large_page_mode(defaultLargePageMode);
+	return 0;
+}
+
+// Keys within a narrow range: SortRadixPar of all digits vs. SortRadixRangePar, which sorts only the bits that differ between keys (or uses Counting Sort)
+template< class _Type >
+static int ParallelRadixSortLsdRangeBenchmark(size_t testSize, _Type base, unsigned long long range, const char* description)
+{
+	std::mt19937_64 dist(1234);
+
+	printf("\nBenchmarking Parallel Radix Sort LSD with %zu %zu-bit unsigned integers of %s...\n\n", testSize, sizeof(_Type) * 8, description);
+	vector<_Type> keys(testSize);
+	for (auto& d : keys)
+		d = static_cast<_Type>(base + dist() % range);
+	vector<_Type> keysCopy(testSize);
+	vector<_Type> sorted_reference(keys);
+	sort(std::execution::par_unseq, sorted_reference.begin(), sorted_reference.end());
+
+	ParallelAlgorithms::RadixSortWorkspace workspace;
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		for (bool rangeCompressed : { false, true })
+		{
+			std::copy(keys.begin(), keys.end(), keysCopy.begin());
+			auto startTime = high_resolution_clock::now();
+			if (rangeCompressed)
+				ParallelAlgorithms::SortRadixRangePar(keysCopy.data(), testSize, workspace);
+			else
+				ParallelAlgorithms::SortRadixPar(keysCopy.data(), testSize, workspace);
+			auto endTime = high_resolution_clock::now();
+			printf("Parallel Radix Sort LSD, %s: %.2f ms\n", rangeCompressed ? "range-compressed" : "all digits      ", duration_cast<duration<double, milli>>(endTime - startTime).count());
+			if (!std::equal(sorted_reference.begin(), sorted_reference.end(), keysCopy.begin()))
+			{
+				printf("Arrays are not equal\n");
+				exit(1);
+			}
+		}
+	}
+	return 0;
+}
+
+int ParallelRadixSortLsdRangeBenchmark()
+{
+	ParallelRadixSortLsdRangeBenchmark< unsigned           >(100'000'000, 3'000'000u,            1ULL << 20,   "IDs in [base, base + 2^20)");
+	ParallelRadixSortLsdRangeBenchmark< unsigned           >(100'000'000, 3'000'000u,            1ULL << 24,   "IDs in [base, base + 2^24)");
+	ParallelRadixSortLsdRangeBenchmark< unsigned long long >( 50'000'000, 1'700'000'000'000ULL, 86'400'000ULL, "millisecond timestamps within one day");
+	ParallelRadixSortLsdRangeBenchmark< unsigned long long >( 50'000'000, 1'700'000'000'000ULL, 1ULL << 20,   "IDs in [base, base + 2^20)");
+	return 0;
+}
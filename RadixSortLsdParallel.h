@@ -21,6 +21,7 @@
 #include <vector>
 #include <execution>
 #include <thread>
+#include <type_traits>
 
 using std::chrono::duration;
 using std::chrono::duration_cast;
@@ -29,6 +30,11 @@ using std::milli;
 
 #include "RadixSortLSD.h"
 #include "HistogramParallel.h"
+#include "RadixSortWorkspace.h"
+#include "LargePageAllocator.h"
+#include "NonTemporalCopy.h"
+#include "CacheInfo.h"
+#include "CountingSortParallel.h"
 
 using namespace tbb;
 
@@ -105,15 +111,25 @@ namespace ParallelAlgorithms
 		}
 	}
 
-	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix >
-	inline size_t** ComputeStartOfBinsPar(unsigned* inArray, size_t size, size_t workQuanta, size_t numberOfQuantas, unsigned digit, size_t parallelThreshold = 16 * 1024)
+	// Converts count[quanta][NumberOfBins] of each work quanta into startOfBin[quanta][NumberOfBins] - the starting index of each bin for each work quanta
+	// Fills in a pre-allocated startOfBin table (e.g. from RadixSortWorkspace), without allocating any memory. Counts may be 32-bit or size_t
+	template< unsigned PowerOfTwoRadix, class _CountType >
+	inline void ComputeStartOfBinsFromCounts(_CountType** count, size_t numberOfQuantas, size_t** startOfBin)
 	{
-		unsigned NumberOfBins = PowerOfTwoRadix;
-
-		//unsigned long** count = HistogramByteComponentsAcrossWorkQuantasQC<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, 0, size - 1, workQuanta, quanta, digit);
-		size_t** count = ParallelAlgorithms::HistogramByteComponentsQCPar<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inArray, 0, size - 1, workQuanta, numberOfQuantas, digit, parallelThreshold);
+		const size_t NumberOfBins = PowerOfTwoRadix;
+		size_t startOfCurrBin = 0;
+		for (size_t b = 0; b < NumberOfBins; b++)
+			for (size_t q = 0; q < numberOfQuantas; q++)
+			{
+				startOfBin[q][b] = startOfCurrBin;
+				startOfCurrBin += count[q][b];
+			}
+	}
 
-		parallelThreshold = 0;
+	template< unsigned PowerOfTwoRadix >
+	inline size_t** ComputeStartOfBinsFromCounts(size_t** count, size_t numberOfQuantas)
+	{
+		unsigned NumberOfBins = PowerOfTwoRadix;
 
 		size_t** startOfBin = new size_t * [numberOfQuantas];     // start of bin for each parallel work item
 		for (size_t q = 0; q < numberOfQuantas; q++)
@@ -155,235 +171,1138 @@ namespace ParallelAlgorithms
 				//    Console.WriteLine("ComputeStartOfBins: d = {0}  sizeOfBin[{1}][{2}] = {3}", currDigit, q, b, startOfBin[q][b]);
 			}
 
-		for (size_t q = 0; q < numberOfQuantas; q++)
-			delete[] count[q];
-		delete[] count;
-
 		delete[] sizeOfBin;
 
 		return startOfBin;
 	}
 
+	// Parallel histogram of a digit for each work quanta into count[quanta][NumberOfBins], followed by startOfBin[quanta][NumberOfBins] of each work quanta
+	// Both tables are pre-allocated (e.g. from RadixSortWorkspace) and reused for every digit
+	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix, class _Type, class _KeyPass = RadixKeyIdentity, class _CountType >
+	inline void ComputeStartOfBinsPar(_Type* inArray, size_t size, size_t workQuanta, size_t numberOfQuantas, unsigned digit, _CountType** count, size_t** startOfBin)
+	{
+		ParallelAlgorithms::HistogramByteComponentsQCPar<PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyPass>(inArray, size, workQuanta, numberOfQuantas, digit, count);
+		ComputeStartOfBinsFromCounts< PowerOfTwoRadix >(count, numberOfQuantas, startOfBin);
+	}
+
+	// Counts the next digit of numItems elements, which are being flushed to outputArray[outIndex], into nextCount[outputQuanta][NumberOfBins]
+	// of the output work quanta they land in. Elements are counted while they are still in the cache, eliminating the histogram pass of the next digit.
+	template< unsigned PowerOfTwoRadix, class _Type, class _NextKeyPass, class _CountType >
+	inline void _RadixSortLSD_CountNextDigitOfFlush(const _Type* items, size_t numItems, size_t outIndex, _CountType* nextCount, size_t outputWorkQuantum, unsigned nextShiftRightAmount)
+	{
+		const _Type mask = PowerOfTwoRadix - 1;
+		while (numItems > 0)
+		{
+			size_t outputQuanta = outIndex / outputWorkQuantum;
+			size_t numInQuanta  = std::min(numItems, (outputQuanta + 1) * outputWorkQuantum - outIndex);	// a flush may straddle two output work quanta
+			_CountType* countLoc = nextCount + outputQuanta * PowerOfTwoRadix;
+			for (size_t i = 0; i < numInQuanta; i++)
+				countLoc[(size_t)((_NextKeyPass::key_in(items[i]) >> nextShiftRightAmount) & mask)]++;
+			items    += numInQuanta;
+			outIndex += numInQuanta;
+			numItems -= numInQuanta;
+		}
+	}
+
 	// Permute phase of LSD Radix Sort with de-randomized write memory accesses
 	// Derandomizes system memory accesses by buffering all Radix bin accesses, turning 256-bin random memory writes into sequential writes
-	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix>
+	// _Type is any unsigned integer type (e.g. 32-bit or 64-bit). _KeyPass transforms signed and floating-point keys on the way in and out (see RadixKeyPass)
+	// When nextCount is not NULL, the next digit (read through _NextKeyPass) is also counted for each output work quanta, fusing the next histogram into this pass
+	// When streamingStores is true, buffers are flushed with non-temporal stores, which bypass the cache (see memcpy_nontemporal)
+	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix, class _Type, class _KeyPass = RadixKeyIdentity, class _NextKeyPass = RadixKeyIdentity, class _CountType = size_t >
 	inline void _RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew(
-		unsigned* inputArray, unsigned* outputArray, size_t q, size_t** startOfBin, size_t startIndex, size_t endIndex,
-		unsigned bitMask, unsigned shiftRightAmount, size_t** bufferIndex, unsigned** bufferDerandomize, size_t* bufferIndexEnd, size_t BufferDepth)
+		_Type* inputArray, _Type* outputArray, size_t q, size_t** startOfBin, size_t startIndex, size_t endIndex,
+		_Type bitMask, unsigned shiftRightAmount, size_t** bufferIndex, _Type** bufferDerandomize, size_t* bufferIndexEnd, size_t BufferDepth,
+		_CountType* nextCount = NULL, size_t outputWorkQuantum = 0, unsigned nextShiftRightAmount = 0, bool streamingStores = false)
 	{
 		size_t* startOfBinLoc = startOfBin[q];
 #if 1
 		const size_t NumberOfBins = PowerOfTwoRadix;
+		const size_t CacheLineSize = 64;
 
 		size_t* bufferIndexLoc = bufferIndex[q];
-		unsigned* bufferDerandomizeLoc = bufferDerandomize[q];
+		_Type* bufferDerandomizeLoc = bufferDerandomize[q];
+
+		// With streaming stores, each bin buffer is aligned with the cache lines of its destination, by starting the bin at the cache line boundary
+		// below its start and skipping the elements before its start on the first flush. Every later flush then writes whole cache lines,
+		// which streaming stores write to system memory without reading them first.
+		unsigned char headSkip[NumberOfBins] = { 0 };
+		if (streamingStores)
+			for (size_t b = 0; b < NumberOfBins; b++)
+			{
+				headSkip[b] = (unsigned char)((((uintptr_t)(outputArray + startOfBinLoc[b])) & (CacheLineSize - 1)) / sizeof(_Type));
+				startOfBinLoc[b]  -= headSkip[b];
+				bufferIndexLoc[b] += headSkip[b];
+			}
 
 		for (size_t currIndex = startIndex; currIndex < endIndex; currIndex++)
 		{
-			unsigned currDigit = extractDigit_1(inputArray[currIndex], bitMask, shiftRightAmount);
+			_Type currKey = _KeyPass::key_in(inputArray[currIndex]);
+			unsigned currDigit = extractDigit_1(currKey, bitMask, shiftRightAmount);
 			if (bufferIndexLoc[currDigit] < bufferIndexEnd[currDigit])
 			{
-				bufferDerandomizeLoc[bufferIndexLoc[currDigit]++] = inputArray[currIndex];
+				bufferDerandomizeLoc[bufferIndexLoc[currDigit]++] = _KeyPass::key_out(currKey);
 			}
 			else
 			{
-				size_t outIndex = startOfBinLoc[currDigit];
-				size_t buffIndex = (size_t)currDigit * BufferDepth;
-				memcpy(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffIndex]), BufferDepth * sizeof(unsigned));	// significantly faster than a for loop
+				size_t skip = headSkip[currDigit];
+				size_t outIndex = startOfBinLoc[currDigit] + skip;
+				size_t buffIndex = (size_t)currDigit * BufferDepth + skip;
+				if (nextCount != NULL)
+					_RadixSortLSD_CountNextDigitOfFlush< PowerOfTwoRadix, _Type, _NextKeyPass >(&(bufferDerandomizeLoc[buffIndex]), BufferDepth - skip, outIndex, nextCount, outputWorkQuantum, nextShiftRightAmount);
+				if (streamingStores)
+				{
+					memcpy_nontemporal(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffIndex]), (BufferDepth - skip) * sizeof(_Type));
+					headSkip[currDigit] = 0;
+				}
+				else
+					memcpy(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffIndex]), BufferDepth * sizeof(_Type));	// significantly faster than a for loop
 				startOfBinLoc[currDigit] += BufferDepth;
-				bufferDerandomizeLoc[currDigit * BufferDepth] = inputArray[currIndex];
+				bufferDerandomizeLoc[currDigit * BufferDepth] = _KeyPass::key_out(currKey);
 				bufferIndexLoc[currDigit] = currDigit * BufferDepth + 1;
 			}
 		}
 		// Flush all the derandomization buffers
 		for (size_t whichBuff = 0; whichBuff < NumberOfBins; whichBuff++)
 		{
-			size_t outIndex = startOfBinLoc[whichBuff];
-			size_t buffStartIndex = whichBuff * BufferDepth;
+			size_t outIndex = startOfBinLoc[whichBuff] + headSkip[whichBuff];
+			size_t buffStartIndex = whichBuff * BufferDepth + headSkip[whichBuff];
 			size_t buffEndIndex = bufferIndexLoc[whichBuff];
 			size_t numItems = buffEndIndex - buffStartIndex;
-			memcpy(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffStartIndex]), numItems * sizeof(unsigned));
+			if (nextCount != NULL)
+				_RadixSortLSD_CountNextDigitOfFlush< PowerOfTwoRadix, _Type, _NextKeyPass >(&(bufferDerandomizeLoc[buffStartIndex]), numItems, outIndex, nextCount, outputWorkQuantum, nextShiftRightAmount);
+			if (streamingStores)
+				memcpy_nontemporal(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffStartIndex]), numItems * sizeof(_Type));
+			else
+				memcpy(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffStartIndex]), numItems * sizeof(_Type));
 			bufferIndexLoc[whichBuff] = whichBuff * BufferDepth;
 		}
+		if (streamingStores)
+			nontemporal_store_fence();		// streaming stores must be visible to all threads before the next pass reads them
 #else
 		for (size_t _current = startIndex; _current < endIndex; _current++)
-			outputArray[startOfBinLoc[extractDigit_1(inputArray[_current], bitMask, shiftRightAmount)]++] = inputArray[_current];
+			outputArray[startOfBinLoc[extractDigit_1(_KeyPass::key_in(inputArray[_current]), bitMask, shiftRightAmount)]++] = _KeyPass::key_out(_KeyPass::key_in(inputArray[_current]));
 #endif
 	}
 
-	// This method is referenced in the Parallel LSD Radix Sort section of Practical Parallel Algorithms Book.
-	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix >
-	inline void SortRadixInnerPar(unsigned* inputArray, unsigned* workArray, size_t inputSize, size_t ParallelWorkQuantum = 64 * 1024)
+	// Counting phase of one digit of the LSD Radix Sort for a single work quanta, into a pre-allocated count row
+	template< unsigned PowerOfTwoRadix, class _Type, class _KeyPass = RadixKeyIdentity, class _CountType >
+	inline void _RadixSortLSD_HistogramDigit(const _Type* inputArray, size_t startIndex, size_t endIndex, unsigned shiftRightAmount, _CountType* count)
+	{
+		for (size_t b = 0; b < PowerOfTwoRadix; b++)
+			count[b] = 0;
+		HistogramOneComponentMulti< PowerOfTwoRadix, _Type, _KeyPass >(inputArray, startIndex, endIndex, shiftRightAmount, count);
+	}
+
+	// Bytes of de-randomization buffer per bin of the parallel LSD Radix Sort: 256 bytes (64 elements of 32-bits, 32 elements of 64-bits) for digits of up to 11 bits,
+	// since buffers of a single cache line per bin made 10-bit and 11-bit digits 25-40% slower than 8-bit digits. Reduced to a single cache line for wider digits,
+	// to keep the buffers of a work quanta within the L2 cache.
+	inline size_t RadixSortBufferBytesPerBin(unsigned log2ofPowerOfTwoRadix)
+	{
+		return log2ofPowerOfTwoRadix <= 11 ? 256 : 64;
+	}
+
+	// A digit is trivial when all elements have the same value of that digit, which shows up as a single bin holding all of the elements.
+	// Permuting by a trivial digit leaves the array unchanged, and can be skipped.
+	template< unsigned PowerOfTwoRadix, class _CountType >
+	inline bool _RadixSortDigitIsTrivial(_CountType** count, size_t numberOfQuantas, size_t inputSize)
+	{
+		size_t b = 0;
+		while (b < PowerOfTwoRadix - 1 && count[0][b] == 0)		// the only non-empty bin must be the first non-empty bin of the first work quanta
+			b++;
+		size_t sizeOfBin = 0;
+		for (size_t q = 0; q < numberOfQuantas; q++)
+			sizeOfBin += count[q][b];
+		return sizeOfBin == inputSize;
+	}
+
+	// One digit of the parallel LSD Radix Sort: parallel histogram of the digit across work quanta, followed by parallel permutation of each work quanta
+	// count and startOfBin are pre-allocated [quanta][NumberOfBins] tables, which are reused for every digit
+	// When countDigit is false, count already holds the histogram of this digit, counted during the permutation of the previous digit.
+	// When nextCount is not NULL, the permutation also counts the next digit for each output work quanta, and leaves the histogram of the next digit in count.
+	// nextCount is [quanta][quanta * NumberOfBins] - a private histogram of all output work quanta for each permutation task, to avoid atomics and false sharing.
+	// FirstDigit is true until the first permutation has been done, as keys are transformed on the way in by the first permutation (see RadixKeyPass).
+	// Returns false when the digit is trivial and the permutation has been skipped, leaving the array unchanged and not counting the next digit.
+	// When numaArenas is not NULL, the tasks of each work quanta run on the NUMA node owning that slice of the array (see NumaTaskArenas).
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Type, class _KeyTransform, bool FirstDigit, bool LastDigit, bool NextLastDigit = false, class _CountType = size_t >
+	inline bool _SortRadixDigitPar(_Type* inputArray, _Type* workArray, size_t inputSize, size_t ParallelWorkQuantum, size_t quanta, int shiftRightAmount,
+		bool countDigit, _CountType** count, size_t** startOfBin, _CountType** nextCount, size_t** bufferIndex, _Type** bufferDerandomize, size_t* bufferIndexEnd, size_t BufferDepth,
+		bool streamingStores, NumaTaskArenas* numaArenas)
+	{
+		typedef RadixKeyPass< _KeyTransform, FirstDigit, LastDigit    > _KeyPass;
+		typedef RadixKeyPass< _KeyTransform, false,      NextLastDigit > _NextKeyPass;
+		const size_t NumberOfBins = PowerOfTwoRadix;
+		QuantaTaskGroup g(numaArenas, ParallelWorkQuantum, inputSize);
+		//const auto startTime_0 = high_resolution_clock::now();
+		if (countDigit)
+		{
+			for (size_t q = 0; q < quanta; q++)
+			{
+				size_t startIndex = q * ParallelWorkQuantum;
+				size_t   endIndex = std::min(startIndex + ParallelWorkQuantum, inputSize);	// non-inclusive
+				g.run(q, [=] {
+					_RadixSortLSD_HistogramDigit<PowerOfTwoRadix, _Type, _KeyPass>(inputArray, startIndex, endIndex, shiftRightAmount, count[q]);
+					});
+			}
+			g.wait();
+		}
+		if (_RadixSortDigitIsTrivial<PowerOfTwoRadix>(count, quanta, inputSize))
+			return false;
+		ComputeStartOfBinsFromCounts<PowerOfTwoRadix>(count, quanta, startOfBin);
+		//const auto endTime_0 = high_resolution_clock::now();
+		//print_results("Parallel Radix Sort LSD/ComputeStartOfBins: ", startTime_0, endTime_0);
+
+		//const auto startTime_1 = high_resolution_clock::now();
+		for (size_t q = 0; q < quanta; q++)
+		{
+			size_t startIndex = q * ParallelWorkQuantum;
+			size_t   endIndex = std::min(startIndex + ParallelWorkQuantum, inputSize);	// non-inclusive, last work quanta may be partially filled
+			g.run(q, [=] {															// important to not pass by reference, as all tasks will then get the same/last value
+				_CountType* nextCountLoc = NULL;
+				if (nextCount != NULL)
+				{
+					nextCountLoc = nextCount[q];
+					for (size_t i = 0; i < quanta * NumberOfBins; i++)
+						nextCountLoc[i] = 0;
+				}
+				_RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew<PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyPass, _NextKeyPass>(
+					inputArray, workArray, q, startOfBin, startIndex, endIndex, (_Type)(PowerOfTwoRadix - 1), shiftRightAmount, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth,
+					nextCountLoc, ParallelWorkQuantum, shiftRightAmount + Log2ofPowerOfTwoRadix, streamingStores);
+				});
+		}
+		g.wait();
+		//const auto endTime_1 = high_resolution_clock::now();
+		//print_results("Parallel Radix Sort LSD/PermuteDerandomizeNew: ", startTime_1, endTime_1);
+
+		if (nextCount != NULL)		// reduce the private histograms of all permutation tasks into the histogram of each output work quanta
+		{
+			for (size_t outQ = 0; outQ < quanta; outQ++)
+			{
+				g.run(outQ, [=] {
+					_CountType* countLoc = count[outQ];
+					for (size_t b = 0; b < NumberOfBins; b++)
+						countLoc[b] = 0;
+					for (size_t q = 0; q < quanta; q++)
+					{
+						const _CountType* nextCountLoc = nextCount[q] + outQ * NumberOfBins;
+						for (size_t b = 0; b < NumberOfBins; b++)
+							countLoc[b] += nextCountLoc[b];
+					}
+					});
+			}
+			g.wait();
+		}
+		return true;
+	}
+
+	// Copies the sorted result from the working buffer back into the destination array, applying _KeyPass::key_out to each key.
+	// Also transforms keys in place, when both arrays are the same.
+	template< class _Type, class _KeyPass >
+	inline void _SortRadixCopyBackPar(const _Type* sourceArray, _Type* destinationArray, size_t inputSize, size_t ParallelWorkQuantum, NumaTaskArenas* numaArenas = NULL)
+	{
+		QuantaTaskGroup g(numaArenas, ParallelWorkQuantum, inputSize);
+		for (size_t startIndex = 0; startIndex < inputSize; startIndex += ParallelWorkQuantum)
+		{
+			size_t endIndex = std::min(startIndex + ParallelWorkQuantum, inputSize);	// non-inclusive
+			g.run(startIndex / ParallelWorkQuantum, [=] {
+				for (size_t currIndex = startIndex; currIndex < endIndex; currIndex++)
+					destinationArray[currIndex] = _KeyPass::key_out(sourceArray[currIndex]);
+				});
+		}
+		g.wait();
+	}
+
+	// Body of SortRadixInnerPar, with counts of _CountType - 32-bit when the work quanta allows it
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Type, class _KeyTransform, class _CountType >
+	inline void _SortRadixInnerPar(_Type* inputArray, _Type* workArray, size_t inputSize, size_t ParallelWorkQuantum, RadixSortWorkspace& workspace, RadixSortStats* stats,
+		unsigned numberOfKeyBits)
 	{
-		//unsigned int numberOfCores = std::thread::hardware_concurrency();
+		if (inputSize == 0)
+			return;
+
 		const size_t NumberOfBins = PowerOfTwoRadix;
-		bool outputArrayHasResult = false;
 		size_t quanta = (inputSize % ParallelWorkQuantum) == 0 ? inputSize / ParallelWorkQuantum
 			: inputSize / ParallelWorkQuantum + 1;
 		// Setup de-randomization buffers for writes during the permutation phase
-		const size_t BufferDepth = 64;
-		unsigned** bufferDerandomize = static_cast<unsigned**>(operator new[](sizeof(unsigned*)* quanta, (std::align_val_t)(64)));
-		for (size_t q = 0; q < quanta; q++)
-			bufferDerandomize[q] = static_cast<unsigned*>(operator new[](sizeof(unsigned)* NumberOfBins* BufferDepth, (std::align_val_t)(64)));
+		const size_t BufferDepth = RadixSortBufferBytesPerBin(Log2ofPowerOfTwoRadix) / sizeof(_Type);		// same buffer size in cache for 32-bit and 64-bit elements
+		_Type** bufferDerandomize = workspace.bin_buffers< _Type >(quanta, NumberOfBins, BufferDepth);
 
-		size_t** bufferIndex = static_cast<size_t**>(operator new[](sizeof(size_t*)* quanta, (std::align_val_t)(64)));
+		size_t** bufferIndex = workspace.buffer_index_table(quanta, NumberOfBins);
 		for (size_t q = 0; q < quanta; q++)
 		{
-			bufferIndex[q] = static_cast<size_t*>(operator new[](sizeof(size_t)* NumberOfBins, (std::align_val_t)(64)));
 			bufferIndex[q][0] = 0;
 			for (size_t b = 1; b < NumberOfBins; b++)
 				bufferIndex[q][b] = bufferIndex[q][b - 1] + BufferDepth;
 		}
-		//unsigned long* bufferIndexEnd = new(std::align_val_t{ 64 }) unsigned long[NumberOfBins];
-		size_t* bufferIndexEnd = static_cast<size_t*>(operator new[](sizeof(size_t)* NumberOfBins, (std::align_val_t)(64)));
+		size_t* bufferIndexEnd = workspace.buffer_index_end(NumberOfBins);
 		bufferIndexEnd[0] = BufferDepth;									// non-inclusive
 		for (size_t b = 1; b < NumberOfBins; b++)
 			bufferIndexEnd[b] = bufferIndexEnd[b - 1] + BufferDepth;
 		// End of de-randomization buffers setup
 
+		_CountType** count      = workspace.count_table< _CountType >(quanta, NumberOfBins);
+		size_t**     startOfBin = workspace.start_of_bin_table(        quanta, NumberOfBins);
+
+		// Fusing the histogram of the next digit into the permutation of the current digit reduces memory passes over the array from 2*D to 1+D,
+		// at the cost of a private histogram of all output work quanta for each permutation task, which is only worthwhile when that is small relative to the array
+		const size_t FusedHistogramMemoryRatio = 8;		// fused histograms may use up to 1/8 of the array size
+		bool fuseHistogram = quanta * quanta * NumberOfBins * sizeof(_CountType) <= inputSize * sizeof(_Type) / FusedHistogramMemoryRatio;
+		_CountType** nextCount = fuseHistogram ? workspace.next_count_table< _CountType >(quanta, quanta * NumberOfBins) : NULL;
+
+		_Type* destinationArray = inputArray;
+		bool streamingStores = workspace.streaming_stores();
+		NumaTaskArenas* numaArenas = workspace.numa_arenas();
+		int shiftRightAmount = 0;
+		bool permutedAnyDigit  = false;
+		bool permutedLastDigit = false;
+		bool countDigit        = true;
+		size_t numberOfDigits = 0, numberOfPassesSkipped = 0;
+
+		while (shiftRightAmount < (int)numberOfKeyBits)    // end processing digits when all of the key bits have been processed
+		{
+			// Signed and floating-point keys are transformed on the fly during the first and the last permutations, without extra passes over the array
+			bool firstDigit    = !permutedAnyDigit;
+			bool lastDigit     = shiftRightAmount +     (int)Log2ofPowerOfTwoRadix >= (int)numberOfKeyBits;
+			bool nextLastDigit = !lastDigit && shiftRightAmount + 2 * (int)Log2ofPowerOfTwoRadix >= (int)numberOfKeyBits;
+			_CountType** nextCountDigit = lastDigit ? NULL : nextCount;
+			bool permuted;
+			if (firstDigit && lastDigit)
+				permuted = _SortRadixDigitPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, true,  true         >(
+					inputArray, workArray, inputSize, ParallelWorkQuantum, quanta, shiftRightAmount, countDigit, count, startOfBin, nextCountDigit, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth, streamingStores, numaArenas);
+			else if (firstDigit && nextLastDigit)
+				permuted = _SortRadixDigitPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, true,  false, true  >(
+					inputArray, workArray, inputSize, ParallelWorkQuantum, quanta, shiftRightAmount, countDigit, count, startOfBin, nextCountDigit, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth, streamingStores, numaArenas);
+			else if (firstDigit)
+				permuted = _SortRadixDigitPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, true,  false, false >(
+					inputArray, workArray, inputSize, ParallelWorkQuantum, quanta, shiftRightAmount, countDigit, count, startOfBin, nextCountDigit, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth, streamingStores, numaArenas);
+			else if (lastDigit)
+				permuted = _SortRadixDigitPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, false, true         >(
+					inputArray, workArray, inputSize, ParallelWorkQuantum, quanta, shiftRightAmount, countDigit, count, startOfBin, nextCountDigit, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth, streamingStores, numaArenas);
+			else if (nextLastDigit)
+				permuted = _SortRadixDigitPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, false, false, true  >(
+					inputArray, workArray, inputSize, ParallelWorkQuantum, quanta, shiftRightAmount, countDigit, count, startOfBin, nextCountDigit, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth, streamingStores, numaArenas);
+			else
+				permuted = _SortRadixDigitPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, false, false, false >(
+					inputArray, workArray, inputSize, ParallelWorkQuantum, quanta, shiftRightAmount, countDigit, count, startOfBin, nextCountDigit, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth, streamingStores, numaArenas);
+
+			if (permuted)
+			{
+				permutedAnyDigit  = true;
+				permutedLastDigit = lastDigit;
+				_Type* tmp = inputArray;          // swap input and output arrays
+				inputArray = workArray;
+				workArray = tmp;
+			}
+			else
+				numberOfPassesSkipped++;
+			countDigit = !fuseHistogram || !permuted;	// the next digit has not been counted when this digit was skipped
+
+			shiftRightAmount += Log2ofPowerOfTwoRadix;
+			numberOfDigits++;
+		}
+		// Skipped passes may leave the result in the working buffer, and skipping the last pass leaves floating-point keys in their transformed representation
+		bool copyBack = inputArray != destinationArray;
+		if (_KeyTransform::TransformsBits && permutedAnyDigit && !permutedLastDigit)
+			_SortRadixCopyBackPar< _Type, RadixKeyPass< _KeyTransform, false, true > >(inputArray, destinationArray, inputSize, ParallelWorkQuantum, numaArenas);
+		else if (copyBack)
+			_SortRadixCopyBackPar< _Type, RadixKeyIdentity >(inputArray, destinationArray, inputSize, ParallelWorkQuantum, numaArenas);
+
+		if (stats != NULL)
+		{
+			stats->numberOfDigits        += numberOfDigits;
+			stats->numberOfPassesSkipped += numberOfPassesSkipped;
+			stats->numberOfCopyBacks     += copyBack ? 1 : 0;
+		}
+	}
+
+	// This method is referenced in the Parallel LSD Radix Sort section of Practical Parallel Algorithms Book.
+	// _Type is any unsigned integer type (e.g. 32-bit or 64-bit). Leaves the result in inputArray, copying it back from workArray only when
+	// trivial digits (a single bin holding all elements) were skipped, leaving an odd number of passes.
+	// _KeyTransform is RadixKeyTransform of the original key type, for sorting signed integer and floating-point keys through their unsigned representation
+	// All working memory (count tables and de-randomization buffers) comes from the workspace, which is reused across calls without allocating.
+	// Counts are 32-bit for work quanta of fewer than 2^32 elements, and size_t otherwise.
+	// Only the bottom numberOfKeyBits of the keys are sorted, for unsigned keys whose upper bits are all zero (e.g. keys with the minimum subtracted),
+	// which leaves out the digits above them. Keys of a _KeyTransform that transforms bits must be sorted by all of their bits.
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Type, class _KeyTransform = RadixKeyTransform< _Type > >
+	inline void SortRadixInnerPar(_Type* inputArray, _Type* workArray, size_t inputSize, size_t ParallelWorkQuantum, RadixSortWorkspace& workspace, RadixSortStats* stats = NULL,
+		unsigned numberOfKeyBits = sizeof(_Type) * 8)
+	{
+		if (ParallelWorkQuantum <= UINT32_MAX)
+			_SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, uint32_t >(inputArray, workArray, inputSize, ParallelWorkQuantum, workspace, stats, numberOfKeyBits);
+		else
+			_SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform, size_t   >(inputArray, workArray, inputSize, ParallelWorkQuantum, workspace, stats, numberOfKeyBits);
+	}
+
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Type, class _KeyTransform = RadixKeyTransform< _Type > >
+	inline void SortRadixInnerPar(_Type* inputArray, _Type* workArray, size_t inputSize, size_t ParallelWorkQuantum = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		RadixSortWorkspace workspace;
+		SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _KeyTransform >(inputArray, workArray, inputSize, ParallelWorkQuantum, workspace, stats);
+	}
+
+	// Work quantum of the parallel LSD Radix Sort: at least parallelThreshold elements, splitting the array into piecesPerCore pieces for each core.
+	// A few more pieces than cores (the default) increases performance.
+	inline size_t _SortRadixParWorkQuantum(size_t a_size, size_t parallelThreshold, size_t piecesPerCore = 4)
+	{
+		// may return 0 when not able to detect
+		size_t processor_count = (size_t)std::thread::hardware_concurrency() * piecesPerCore;
+
+		if ((processor_count > 0) && (parallelThreshold * processor_count) < a_size)
+			parallelThreshold = a_size / processor_count;
+		return parallelThreshold;
+	}
+
+	// LSD Radix Sort - stable (LSD has to be, and this may preclude LSD Radix from being able to be in-place)
+	// Result is returned in "a", whereas "b" is used a temporary working buffer.
+	inline void SortRadixPar(unsigned* a, size_t a_size, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned long PowerOfTwoRadix = 256;
+		const unsigned long Log2ofPowerOfTwoRadix = 8;
+
+		unsigned* b = allocate_working_buffer< unsigned >(a_size);		// this allocation does slow things down a bit. If we want even faster, then pass "b" in as an argument
+
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold);
+
+		// The beauty of using template arguments instead of function parameters for the Threshold and Log2ofPowerOfTwoRadix is
+		// they are not pushed on the stack and are treated as constants, but local.
+		if (a_size >= Threshold)
+			SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, b, a_size, parallelThreshold, stats);
+		else
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+
+		free_working_buffer(b, a_size);
+	}
+
+	// 16-bit unsigned keys are sorted by the parallel Counting Sort, which reads and writes the array once, instead of once per digit, and needs no working buffer
+	inline void SortRadixPar(unsigned short* a, size_t a_size)
+	{
+		counting_sort_parallel(a, a_size);
+	}
+
+	// Faster implementation, when the user is willing to provide a pre-alocated temporary/working buffer, which makes it a bit more cumbersome to use
+	inline void SortRadixPar(unsigned* a, unsigned* tmp_work_buff, size_t a_size, size_t parallelThreshold = 512 * 1024, RadixSortStats* stats = NULL)
+	{
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold, 1);		// one piece per core
+
+		// The beauty of using template arguments instead of function parameters for the Threshold and Log2ofPowerOfTwoRadix is
+		// they are not pushed on the stack and are treated as constants, but local.
+		if (a_size >= Threshold)
+			SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, tmp_work_buff, a_size, parallelThreshold, stats);
+		else
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);	// TODO: Replace with Parallel Merge Sort to use a bigger Threshold, such at parallelThreshold
+	}
+
+	// LSD Radix Sort - stable, with the temporary/working buffer and all other working memory coming from a workspace that is reused across calls.
+	// Sorting many arrays with the same workspace eliminates per-call allocations and page faults, once the workspace has grown to the largest array.
+	inline void SortRadixPar(unsigned* a, size_t a_size, RadixSortWorkspace& workspace, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+
+		if (a_size < Threshold)
+		{
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+			return;
+		}
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold);
+
+		SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, workspace.work_buffer< unsigned >(a_size), a_size, parallelThreshold, workspace, stats);
+	}
+
+	// LSD Radix Sort of 64-bit unsigned keys (e.g. timestamps, hashed IDs, packed composite keys) - stable
+	// Same algorithm as the 32-bit version above, with 8 digits of 8-bits each. Even number of digits leaves the result in "a".
+	// Also sorts signed integer (int32/int64) and floating-point (float/double) keys, through their order-preserving unsigned representation (see RadixKeyTransform)
+	// Faster implementation, when the user is willing to provide a pre-alocated temporary/working buffer
+	template< class _Type >
+	inline void SortRadixPar(_Type* a, _Type* tmp_work_buff, size_t a_size, size_t parallelThreshold = 512 * 1024, RadixSortStats* stats = NULL)
+	{
+		static_assert((std::is_unsigned<_Type>::value && sizeof(_Type) == 8) || (std::is_signed<_Type>::value && (sizeof(_Type) == 4 || sizeof(_Type) == 8)),
+			"SortRadixPar: only 64-bit unsigned, 32/64-bit signed integer and float/double keys are supported by this overload");
+		typedef RadixKeyTransform< _Type > _KeyTransform;
+		typedef typename _KeyTransform::UnsignedType _UnsignedType;
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold, 1);		// one piece per core
+
+		if (a_size >= Threshold)
+			SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _UnsignedType, _KeyTransform >((_UnsignedType*)a, (_UnsignedType*)tmp_work_buff, a_size, parallelThreshold, stats);
+		else
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+	}
+
+	// LSD Radix Sort of 64-bit unsigned, 32/64-bit signed integer and float/double keys - stable
+	// Result is returned in "a", whereas "b" is used a temporary working buffer.
+	template< class _Type >
+	inline void SortRadixPar(_Type* a, size_t a_size, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		static_assert((std::is_unsigned<_Type>::value && sizeof(_Type) == 8) || (std::is_signed<_Type>::value && (sizeof(_Type) == 4 || sizeof(_Type) == 8)),
+			"SortRadixPar: only 64-bit unsigned, 32/64-bit signed integer and float/double keys are supported by this overload");
+		typedef RadixKeyTransform< _Type > _KeyTransform;
+		typedef typename _KeyTransform::UnsignedType _UnsignedType;
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+
+		if (a_size < Threshold)
+		{
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+			return;
+		}
+		_Type* b = allocate_working_buffer< _Type >(a_size);
+
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold);
+
+		SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _UnsignedType, _KeyTransform >((_UnsignedType*)a, (_UnsignedType*)b, a_size, parallelThreshold, stats);
+
+		free_working_buffer(b, a_size);
+	}
+
+	// LSD Radix Sort of 64-bit unsigned, 32/64-bit signed integer and float/double keys - stable, with all working memory coming from a reusable workspace
+	template< class _Type >
+	inline void SortRadixPar(_Type* a, size_t a_size, RadixSortWorkspace& workspace, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		static_assert((std::is_unsigned<_Type>::value && sizeof(_Type) == 8) || (std::is_signed<_Type>::value && (sizeof(_Type) == 4 || sizeof(_Type) == 8)),
+			"SortRadixPar: only 64-bit unsigned, 32/64-bit signed integer and float/double keys are supported by this overload");
+		typedef RadixKeyTransform< _Type > _KeyTransform;
+		typedef typename _KeyTransform::UnsignedType _UnsignedType;
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+
+		if (a_size < Threshold)
+		{
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+			return;
+		}
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold);
+
+		SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _UnsignedType, _KeyTransform >(
+			(_UnsignedType*)a, workspace.work_buffer< _UnsignedType >(a_size), a_size, parallelThreshold, workspace, stats);
+	}
+
+	// Selects the digit width of the parallel LSD Radix Sort for keys of sizeOfKey bytes and work quanta of parallelWorkQuantum elements.
+	// Picks the fewest passes over the array whose digit fits the cache budget of a core: the de-randomization buffers of a work quanta, which every
+	// element is written to, together with its counts, start-of-bin and buffer indexes, within half of the L2 cache. The 64 KB of buffers of 8-bit digits
+	// already exceed most L1 data caches, and are held in L2 as well. Work quanta must also be large enough to fill each bin buffer at least once on average.
+	// Returns 8, 10 or 11 bits - the narrowest digit for 4 or 3 passes of 32-bit keys, and 8, 7 or 6 passes of 64-bit keys (11-bit digits need an L2 cache of more than 1 MB).
+	// Keys with fewer significant bits (numberOfKeyBits) than their size are sorted in fewer passes, e.g. 20-bit keys in 2 passes of 10 bits when those fit the caches.
+	inline unsigned SelectRadixDigitBits(size_t sizeOfKey, size_t parallelWorkQuantum, unsigned numberOfKeyBits)
+	{
+		const unsigned CandidateDigitBits[] = { 10, 11 };
+		size_t keyBits = numberOfKeyBits;
+		unsigned digitBits = 8;
+		size_t numberOfPasses = (keyBits + 7) / 8;
+		for (unsigned bits : CandidateDigitBits)
+		{
+			size_t numberOfBins = (size_t)1 << bits;
+			size_t bitsPasses   = (keyBits + bits - 1) / bits;
+			if (bitsPasses >= numberOfPasses)
+				continue;
+			bool fitsL2              = numberOfBins * (RadixSortBufferBytesPerBin(bits) + 3 * sizeof(size_t)) <= CacheSizeL2() / 2;
+			bool quantumFillsBuffers = parallelWorkQuantum >= numberOfBins * (RadixSortBufferBytesPerBin(bits) / sizeOfKey);
+			if (fitsL2 && quantumFillsBuffers)
+			{
+				digitBits      = bits;
+				numberOfPasses = bitsPasses;
+			}
+		}
+		return digitBits;
+	}
+
+	inline unsigned SelectRadixDigitBits(size_t sizeOfKey, size_t parallelWorkQuantum)
+	{
+		return SelectRadixDigitBits(sizeOfKey, parallelWorkQuantum, (unsigned)(sizeOfKey * 8));
+	}
+
+	// Parallel LSD Radix Sort with BitsPerDigit-bit digits - stable. Wider digits take fewer passes over the array: e.g. 11-bit digits sort 32-bit keys
+	// in 3 passes of 11/11/10 bits, instead of 4 passes of 8 bits, and 64-bit keys in 6 passes instead of 8. The last digit holds the remaining bits.
+	// Sorts 32/64-bit unsigned, signed integer and float/double keys. Result is returned in "a", with all working memory coming from the workspace.
+	template< unsigned BitsPerDigit, class _Type >
+	inline void SortRadixNbitPar(_Type* a, size_t a_size, RadixSortWorkspace& workspace, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		static_assert(BitsPerDigit >= 1 && BitsPerDigit <= 16, "SortRadixNbitPar: digits of 1 to 16 bits are supported");
+		static_assert(sizeof(_Type) == 4 || sizeof(_Type) == 8, "SortRadixNbitPar: only 32-bit and 64-bit keys are supported");
+		typedef RadixKeyTransform< _Type > _KeyTransform;
+		typedef typename _KeyTransform::UnsignedType _UnsignedType;
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+
+		if (a_size < Threshold)
+		{
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+			return;
+		}
+		SortRadixInnerPar< 1UL << BitsPerDigit, BitsPerDigit, _UnsignedType, _KeyTransform >(
+			(_UnsignedType*)a, workspace.work_buffer< _UnsignedType >(a_size), a_size, _SortRadixParWorkQuantum(a_size, parallelThreshold), workspace, stats);
+	}
+
+	template< unsigned BitsPerDigit, class _Type >
+	inline void SortRadixNbitPar(_Type* a, size_t a_size, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		RadixSortWorkspace workspace;
+		SortRadixNbitPar< BitsPerDigit >(a, a_size, workspace, parallelThreshold, stats);
+	}
+
+	// Parallel LSD Radix Sort with the digit width selected at run-time from the cache sizes of the machine and the work quantum (see SelectRadixDigitBits)
+	template< class _Type >
+	inline void SortRadixNbitPar(_Type* a, size_t a_size, RadixSortWorkspace& workspace, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		switch (SelectRadixDigitBits(sizeof(_Type), _SortRadixParWorkQuantum(a_size, parallelThreshold)))
+		{
+		case 10:  SortRadixNbitPar< 10 >(a, a_size, workspace, parallelThreshold, stats);  break;
+		case 11:  SortRadixNbitPar< 11 >(a, a_size, workspace, parallelThreshold, stats);  break;
+		default:  SortRadixNbitPar<  8 >(a, a_size, workspace, parallelThreshold, stats);  break;
+		}
+	}
+
+	template< class _Type >
+	inline void SortRadixNbitPar(_Type* a, size_t a_size, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		RadixSortWorkspace workspace;
+		SortRadixNbitPar(a, a_size, workspace, parallelThreshold, stats);
+	}
+
+	// Minimum and maximum of an array in a single parallel pass, with each work quanta reducing its own slice
+	template< class _Type >
+	inline void _MinMaxPar(const _Type* a, size_t a_size, size_t ParallelWorkQuantum, _Type& minValue, _Type& maxValue, NumaTaskArenas* numaArenas = NULL)
+	{
+		size_t quanta = (a_size + ParallelWorkQuantum - 1) / ParallelWorkQuantum;
+		std::vector< _Type > quantaMin(quanta), quantaMax(quanta);
+		QuantaTaskGroup g(numaArenas, ParallelWorkQuantum, a_size);
+		for (size_t q = 0; q < quanta; q++)
+		{
+			size_t startIndex = q * ParallelWorkQuantum;
+			size_t   endIndex = std::min(startIndex + ParallelWorkQuantum, a_size);	// non-inclusive
+			g.run(q, [=, &quantaMin, &quantaMax] {
+				_Type minLoc = a[startIndex], maxLoc = a[startIndex];
+				for (size_t currIndex = startIndex + 1; currIndex < endIndex; currIndex++)
+				{
+					minLoc = (std::min)(minLoc, a[currIndex]);
+					maxLoc = (std::max)(maxLoc, a[currIndex]);
+				}
+				quantaMin[q] = minLoc;
+				quantaMax[q] = maxLoc;
+				});
+		}
+		g.wait();
+		minValue = *std::min_element(quantaMin.begin(), quantaMin.end());
+		maxValue = *std::max_element(quantaMax.begin(), quantaMax.end());
+	}
+
+	// Adds "offset" to every key in parallel, which wraps around for unsigned keys, and subtracts when offset is the negated value
+	template< class _Type >
+	inline void _AddOffsetPar(_Type* a, size_t a_size, size_t ParallelWorkQuantum, _Type offset, NumaTaskArenas* numaArenas = NULL)
+	{
+		QuantaTaskGroup g(numaArenas, ParallelWorkQuantum, a_size);
+		for (size_t startIndex = 0; startIndex < a_size; startIndex += ParallelWorkQuantum)
+		{
+			size_t endIndex = std::min(startIndex + ParallelWorkQuantum, a_size);	// non-inclusive
+			g.run(startIndex / ParallelWorkQuantum, [=] {
+				for (size_t currIndex = startIndex; currIndex < endIndex; currIndex++)
+					a[currIndex] += offset;
+				});
+		}
+		g.wait();
+	}
+
+	// Number of bits up to and including the highest set bit, which is 0 for 0
+	template< class _Type >
+	inline unsigned _NumberOfSignificantBits(_Type value)
+	{
+		unsigned numberOfBits = 0;
+		for (; value != 0; value >>= 1)
+			numberOfBits++;
+		return numberOfBits;
+	}
+
+	// Sorts the bottom numberOfKeyBits of unsigned keys, with digits of digitBits (one of the widths returned by SelectRadixDigitBits)
+	template< class _Type >
+	inline void _SortRadixKeyBitsPar(_Type* a, size_t a_size, RadixSortWorkspace& workspace, size_t ParallelWorkQuantum, RadixSortStats* stats, unsigned digitBits, unsigned numberOfKeyBits)
+	{
+		_Type* b = workspace.work_buffer< _Type >(a_size);
+		switch (digitBits)
+		{
+		case 10:  SortRadixInnerPar< 1UL << 10, 10, _Type >(a, b, a_size, ParallelWorkQuantum, workspace, stats, numberOfKeyBits);  break;
+		case 11:  SortRadixInnerPar< 1UL << 11, 11, _Type >(a, b, a_size, ParallelWorkQuantum, workspace, stats, numberOfKeyBits);  break;
+		default:  SortRadixInnerPar< 1UL <<  8,  8, _Type >(a, b, a_size, ParallelWorkQuantum, workspace, stats, numberOfKeyBits);  break;
+		}
+	}
+
+	// Range-compressed parallel LSD Radix Sort of 32/64-bit unsigned keys, which occupy a narrow range of values (e.g. IDs in [base, base + 2^20),
+	// or timestamps within one day). A parallel pass finds the minimum and the maximum together, and only the bits which differ between keys are sorted:
+	// - ranges of fewer than CountingSortMaximumNumberOfValues() values are sorted by Counting Sort, in a single pass, when the histograms of its work quantas
+	//   take no more than half of the memory of the array (see _CountingSortNumberOfQuantas)
+	// - otherwise, keys share all of their bits above the highest bit of (min ^ max), and are sorted by the bits below it, with no other passes over the array
+	// - unless the range straddles a power of two of many more bits than itself (e.g. [2^31 - 2^20, 2^31 + 2^20)), when sorting (key - min) is at least two
+	//   digit passes fewer, which pays for the two passes that subtract the minimum and add it back
+	// Digit width is selected for the number of sorted bits (see SelectRadixDigitBits), e.g. a range of 20 bits takes 2 passes of 10 bits, instead of 3 of 8 bits.
+	// Result is returned in "a", with all working memory coming from the workspace.
+	template< class _Type >
+	inline void SortRadixRangePar(_Type* a, size_t a_size, RadixSortWorkspace& workspace, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		static_assert(std::is_unsigned<_Type>::value && (sizeof(_Type) == 4 || sizeof(_Type) == 8), "SortRadixRangePar: only 32-bit and 64-bit unsigned keys are supported");
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+
+		if (a_size < Threshold)
+		{
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+			return;
+		}
+		size_t ParallelWorkQuantum = _SortRadixParWorkQuantum(a_size, parallelThreshold);
+		NumaTaskArenas* numaArenas = workspace.numa_arenas();
+		_Type minValue, maxValue;
+		_MinMaxPar(a, a_size, ParallelWorkQuantum, minValue, maxValue, numaArenas);
+		if (minValue == maxValue)
+			return;
+
+		_Type range = maxValue - minValue;
+		size_t countingQuantas = range < CountingSortMaximumNumberOfValues() ? _CountingSortNumberOfQuantas(a_size, sizeof(_Type), (size_t)range + 1) : 0;
+		if (countingQuantas > 0)
+		{
+			counting_sort_parallel_inner< _Type >(a, a_size, minValue, (size_t)range + 1, countingQuantas);
+			return;
+		}
+		unsigned rangeBits  = _NumberOfSignificantBits(range);
+		unsigned prefixBits = _NumberOfSignificantBits((_Type)(minValue ^ maxValue));	// bits above these are the same in all keys
+		unsigned rangeDigitBits  = SelectRadixDigitBits(sizeof(_Type), ParallelWorkQuantum, rangeBits);
+		unsigned prefixDigitBits = SelectRadixDigitBits(sizeof(_Type), ParallelWorkQuantum, prefixBits);
+		unsigned rangePasses  = (rangeBits  + rangeDigitBits  - 1) / rangeDigitBits;
+		unsigned prefixPasses = (prefixBits + prefixDigitBits - 1) / prefixDigitBits;
+
+		if (prefixPasses >= rangePasses + 2)
+		{
+			_AddOffsetPar(a, a_size, ParallelWorkQuantum, (_Type)(0 - minValue), numaArenas);
+			_SortRadixKeyBitsPar(a, a_size, workspace, ParallelWorkQuantum, stats, rangeDigitBits, rangeBits);
+			_AddOffsetPar(a, a_size, ParallelWorkQuantum, minValue, numaArenas);
+		}
+		else
+			_SortRadixKeyBitsPar(a, a_size, workspace, ParallelWorkQuantum, stats, prefixDigitBits, prefixBits);
+	}
+
+	template< class _Type >
+	inline void SortRadixRangePar(_Type* a, size_t a_size, size_t parallelThreshold = 64 * 1024, RadixSortStats* stats = NULL)
+	{
+		RadixSortWorkspace workspace;
+		SortRadixRangePar(a, a_size, workspace, parallelThreshold, stats);
+	}
+
+	// Permute phase of key-value LSD Radix Sort with de-randomized write memory accesses
+	// Keys and values are separate arrays (SoA), which are permuted in lockstep through two sets of de-randomization buffers
+	// that share the same buffer indexes. Stable, since elements within each work quanta are processed in order.
+	template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix, class _KeyType, class _ValueType >
+	inline void _RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew_KeyValue(
+		_KeyType* inputKeys, _KeyType* outputKeys, _ValueType* inputValues, _ValueType* outputValues, size_t q, size_t** startOfBin, size_t startIndex, size_t endIndex,
+		_KeyType bitMask, unsigned shiftRightAmount, size_t** bufferIndex, _KeyType** keyBufferDerandomize, _ValueType** valueBufferDerandomize, size_t* bufferIndexEnd, size_t BufferDepth)
+	{
+		const size_t NumberOfBins = PowerOfTwoRadix;
+		size_t*     startOfBinLoc       = startOfBin[q];
+		size_t*     bufferIndexLoc      = bufferIndex[q];
+		_KeyType*   keyBufferLoc        = keyBufferDerandomize[q];
+		_ValueType* valueBufferLoc      = valueBufferDerandomize[q];
+
+		for (size_t currIndex = startIndex; currIndex < endIndex; currIndex++)
+		{
+			unsigned currDigit = extractDigit_1(inputKeys[currIndex], bitMask, shiftRightAmount);
+			if (bufferIndexLoc[currDigit] < bufferIndexEnd[currDigit])
+			{
+				keyBufferLoc[  bufferIndexLoc[currDigit]] = inputKeys[  currIndex];
+				valueBufferLoc[bufferIndexLoc[currDigit]] = inputValues[currIndex];
+				bufferIndexLoc[currDigit]++;
+			}
+			else
+			{
+				size_t outIndex  = startOfBinLoc[currDigit];
+				size_t buffIndex = (size_t)currDigit * BufferDepth;
+				memcpy(&(outputKeys[  outIndex]), &(keyBufferLoc[  buffIndex]), BufferDepth * sizeof(_KeyType));
+				memcpy(&(outputValues[outIndex]), &(valueBufferLoc[buffIndex]), BufferDepth * sizeof(_ValueType));
+				startOfBinLoc[currDigit] += BufferDepth;
+				keyBufferLoc[  buffIndex] = inputKeys[  currIndex];
+				valueBufferLoc[buffIndex] = inputValues[currIndex];
+				bufferIndexLoc[currDigit] = buffIndex + 1;
+			}
+		}
+		// Flush all the derandomization buffers
+		for (size_t whichBuff = 0; whichBuff < NumberOfBins; whichBuff++)
+		{
+			size_t outIndex       = startOfBinLoc[whichBuff];
+			size_t buffStartIndex = whichBuff * BufferDepth;
+			size_t numItems       = bufferIndexLoc[whichBuff] - buffStartIndex;
+			memcpy(&(outputKeys[  outIndex]), &(keyBufferLoc[  buffStartIndex]), numItems * sizeof(_KeyType));
+			memcpy(&(outputValues[outIndex]), &(valueBufferLoc[buffStartIndex]), numItems * sizeof(_ValueType));
+			bufferIndexLoc[whichBuff] = buffStartIndex;
+		}
+	}
+
+	// Body of SortRadixByKeyInnerPar, with counts of _CountType - 32-bit when the work quanta allows it
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _KeyType, class _ValueType, class _CountType >
+	inline void _SortRadixByKeyInnerPar(_KeyType* inputKeys, _ValueType* inputValues, _KeyType* workKeys, _ValueType* workValues, size_t inputSize, size_t ParallelWorkQuantum,
+		RadixSortWorkspace& workspace)
+	{
+		const size_t NumberOfBins = PowerOfTwoRadix;
 		if (inputSize == 0)
 			return;
+		size_t quanta = (inputSize % ParallelWorkQuantum) == 0 ? inputSize / ParallelWorkQuantum
+			: inputSize / ParallelWorkQuantum + 1;
+		// Setup de-randomization buffers for writes during the permutation phase. Keys and values share buffer indexes, thus the same depth
+		// of at least one element, for values larger than 256 bytes
+		const size_t BufferDepth = (std::max)((size_t)1, (size_t)256 / (std::max)(sizeof(_KeyType), sizeof(_ValueType)));
+		_KeyType**   keyBufferDerandomize   = workspace.bin_buffers<       _KeyType   >(quanta, NumberOfBins, BufferDepth);
+		_ValueType** valueBufferDerandomize = workspace.value_bin_buffers< _ValueType >(quanta, NumberOfBins, BufferDepth);
+		size_t**     bufferIndex            = workspace.buffer_index_table(quanta, NumberOfBins);
+		for (size_t q = 0; q < quanta; q++)
+			for (size_t b = 0; b < NumberOfBins; b++)
+				bufferIndex[q][b] = b * BufferDepth;
+		size_t* bufferIndexEnd = workspace.buffer_index_end(NumberOfBins);	// non-inclusive
+		for (size_t b = 0; b < NumberOfBins; b++)
+			bufferIndexEnd[b] = (b + 1) * BufferDepth;
+		// End of de-randomization buffers setup
 
-		// Use TPL ideas from https://docs.microsoft.com/en-us/dotnet/standard/parallel-programming/task-based-asynchronous-programming
+		_CountType** count      = workspace.count_table< _CountType >(quanta, NumberOfBins);
+		size_t**     startOfBin = workspace.start_of_bin_table(        quanta, NumberOfBins);
 
-		unsigned bitMask = PowerOfTwoRadix - 1;
 		int shiftRightAmount = 0;
 		unsigned digit = 0;
+		size_t numberOfFullQuantas = inputSize / ParallelWorkQuantum;
 
-		while (bitMask != 0)    // end processing digits when all the mask bits have been processed and shifted out, leaving no bits set in the bitMask
+		for (_KeyType bitMask = PowerOfTwoRadix - 1; bitMask != 0; bitMask <<= Log2ofPowerOfTwoRadix)
 		{
-			//const auto startTime_0 = high_resolution_clock::now();
-			size_t** startOfBin = ComputeStartOfBinsPar<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inputArray, inputSize, ParallelWorkQuantum, quanta, digit);
-			//const auto endTime_0 = high_resolution_clock::now();
-			//print_results("Parallel Radix Sort LSD/ComputeStartOfBinsPar: ", startTime_0, endTime_0);
+			ComputeStartOfBinsPar<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(inputKeys, inputSize, ParallelWorkQuantum, quanta, digit, count, startOfBin);
 
-			size_t numberOfFullQuantas = inputSize / ParallelWorkQuantum;
-			size_t q;
-			//cout << "NumberOfQuantas = " << quanta << "   NumberOfFullQuantas = " << numberOfFullQuantas << endl;
-#if 0
-		// Single core version of the algorithm
-			for (q = 0; q < numberOfFullQuantas; q++)
+#if defined(USE_PPL)
+			Concurrency::task_group g;
+#else
+			tbb::task_group g;
+#endif
+			for (size_t q = 0; q < quanta; q++)
 			{
 				size_t startIndex = q * ParallelWorkQuantum;
-				size_t   endIndex = startIndex + ParallelWorkQuantum;	// non-inclusive
+				size_t   endIndex = q < numberOfFullQuantas ? startIndex + ParallelWorkQuantum : inputSize;	// non-inclusive
+				g.run([=] {																// important to not pass by reference, as all tasks will then get the same/last value
+					_RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew_KeyValue<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(
+						inputKeys, workKeys, inputValues, workValues, q, startOfBin, startIndex, endIndex, (_KeyType)(PowerOfTwoRadix - 1), shiftRightAmount,
+						bufferIndex, keyBufferDerandomize, valueBufferDerandomize, bufferIndexEnd, BufferDepth);
+					});
+			}
+			g.wait();
+
+			digit++;
+			shiftRightAmount += Log2ofPowerOfTwoRadix;
+			std::swap(inputKeys,   workKeys);
+			std::swap(inputValues, workValues);
+		}
+	}
+
+	// Key-value version of SortRadixInnerPar. Values are moved along with their keys, using the same per work quanta bin starts.
+	// _KeyType is any unsigned integer type with an even number of bytes/digits (e.g. 32-bit or 64-bit), which leaves the result in inputKeys/inputValues
+	// De-randomization buffers and count tables come from the workspace, which is reused across calls without allocating.
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _KeyType, class _ValueType >
+	inline void SortRadixByKeyInnerPar(_KeyType* inputKeys, _ValueType* inputValues, _KeyType* workKeys, _ValueType* workValues, size_t inputSize, size_t ParallelWorkQuantum,
+		RadixSortWorkspace& workspace)
+	{
+		if (ParallelWorkQuantum <= UINT32_MAX)
+			_SortRadixByKeyInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _KeyType, _ValueType, uint32_t >(inputKeys, inputValues, workKeys, workValues, inputSize, ParallelWorkQuantum, workspace);
+		else
+			_SortRadixByKeyInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _KeyType, _ValueType, size_t   >(inputKeys, inputValues, workKeys, workValues, inputSize, ParallelWorkQuantum, workspace);
+	}
+
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _KeyType, class _ValueType >
+	inline void SortRadixByKeyInnerPar(_KeyType* inputKeys, _ValueType* inputValues, _KeyType* workKeys, _ValueType* workValues, size_t inputSize, size_t ParallelWorkQuantum = 64 * 1024)
+	{
+		RadixSortWorkspace workspace;
+		SortRadixByKeyInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(inputKeys, inputValues, workKeys, workValues, inputSize, ParallelWorkQuantum, workspace);
+	}
+
+	// Key-value (sort by key) LSD Radix Sort - stable. Keys and values are separate arrays of the same size.
+	// Keys are 32-bit or 64-bit unsigned integers. Values can be of any trivially copyable type (e.g. row index, pointer, 32-bit value).
+	// Result is returned in keys/values, with tmp_keys/tmp_values used as temporary working buffers.
+	template< class _KeyType, class _ValueType >
+	inline void SortRadixByKeyPar(_KeyType* keys, _ValueType* values, _KeyType* tmp_keys, _ValueType* tmp_values, size_t size, size_t parallelThreshold = 512 * 1024)
+	{
+		static_assert(std::is_unsigned<_KeyType>::value && (sizeof(_KeyType) == 4 || sizeof(_KeyType) == 8), "SortRadixByKeyPar: only 32-bit and 64-bit unsigned keys are supported");
+		static_assert(std::is_trivially_copyable<_ValueType>::value, "SortRadixByKeyPar: values must be trivially copyable");
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+
+		parallelThreshold = _SortRadixParWorkQuantum(size, parallelThreshold, 1);		// one piece per core
+
+		if (size >= Threshold)
+			SortRadixByKeyInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(keys, values, tmp_keys, tmp_values, size, parallelThreshold);
+		else
+			insertionSortByKey(keys, values, size);
+	}
+
+	// Key-value (sort by key) LSD Radix Sort - stable, allocating its own temporary working buffers
+	template< class _KeyType, class _ValueType >
+	inline void SortRadixByKeyPar(_KeyType* keys, _ValueType* values, size_t size, size_t parallelThreshold = 64 * 1024)
+	{
+		static_assert(std::is_unsigned<_KeyType>::value && (sizeof(_KeyType) == 4 || sizeof(_KeyType) == 8), "SortRadixByKeyPar: only 32-bit and 64-bit unsigned keys are supported");
+		static_assert(std::is_trivially_copyable<_ValueType>::value, "SortRadixByKeyPar: values must be trivially copyable");
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+		if (size < Threshold)
+		{
+			insertionSortByKey(keys, values, size);
+			return;
+		}
+		_KeyType*   tmp_keys   = allocate_working_buffer< _KeyType   >(size);
+		_ValueType* tmp_values = allocate_working_buffer< _ValueType >(size);
+
+		parallelThreshold = _SortRadixParWorkQuantum(size, parallelThreshold);
+
+		SortRadixByKeyInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(keys, values, tmp_keys, tmp_values, size, parallelThreshold);	// not through the overload above, which clamps to one work quanta per core
+
+		free_working_buffer(tmp_values, size);
+		free_working_buffer(tmp_keys,   size);
+	}
+
+	// Key-value (sort by key) LSD Radix Sort - stable, with the temporary working buffers and all other working memory coming from a reusable workspace
+	template< class _KeyType, class _ValueType >
+	inline void SortRadixByKeyPar(_KeyType* keys, _ValueType* values, size_t size, RadixSortWorkspace& workspace, size_t parallelThreshold = 64 * 1024)
+	{
+		static_assert(std::is_unsigned<_KeyType>::value && (sizeof(_KeyType) == 4 || sizeof(_KeyType) == 8), "SortRadixByKeyPar: only 32-bit and 64-bit unsigned keys are supported");
+		static_assert(std::is_trivially_copyable<_ValueType>::value, "SortRadixByKeyPar: values must be trivially copyable");
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
 
-				_RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew<PowerOfTwoRadix, Log2ofPowerOfTwoRadix, BufferDepth>(
-					inputArray, workArray, q, startOfBin, startIndex, endIndex, bitMask, shiftRightAmount, bufferIndex, bufferDerandomize, bufferIndexEnd);
+		if (size < Threshold)
+		{
+			insertionSortByKey(keys, values, size);
+			return;
+		}
+		SortRadixByKeyInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(keys, values, workspace.work_buffer< _KeyType >(size), workspace.value_work_buffer< _ValueType >(size), size,
+			_SortRadixParWorkQuantum(size, parallelThreshold), workspace);
+	}
+
+	// Stable argsort: returns in "indices" the positions of keys in sorted order, leaving keys unmodified.
+	// Equal keys keep their original relative order, since LSD Radix Sort is stable.
+	template< class _KeyType, class _IndexType >
+	inline void ArgSortRadixPar(const _KeyType* keys, _IndexType* indices, size_t size, size_t parallelThreshold = 64 * 1024)
+	{
+		static_assert(std::is_integral<_IndexType>::value, "ArgSortRadixPar: indices must be of integral type");
+		_KeyType* keys_copy = allocate_working_buffer< _KeyType >(size);
+#if defined(USE_PPL)
+		Concurrency::parallel_for(size_t(0), size, [&](size_t i)
+#else
+		tbb::parallel_for(size_t(0), size, [&](size_t i)
+#endif
+		{
+			keys_copy[i] = keys[i];
+			indices[i]   = (_IndexType)i;
+		});
+		SortRadixByKeyPar(keys_copy, indices, size, parallelThreshold);
+		free_working_buffer(keys_copy, size);
+	}
+
+	// Counting phase of one digit of the record LSD Radix Sort, for a single work quanta of records
+	template< unsigned PowerOfTwoRadix, class _Record, class _KeyFunction, class _CountType >
+	inline void _RadixSortLSD_HistogramRecordsDigit(const _Record* inputArray, size_t startIndex, size_t endIndex, _KeyFunction getKey, unsigned shiftRightAmount, _CountType* count)
+	{
+		const size_t mask = PowerOfTwoRadix - 1;
+		for (size_t b = 0; b < PowerOfTwoRadix; b++)
+			count[b] = 0;
+		for (size_t currIndex = startIndex; currIndex < endIndex; currIndex++)
+			count[(size_t)(radix_key_to_unsigned(getKey(inputArray[currIndex])) >> shiftRightAmount) & mask]++;
+	}
+
+	// Permute phase of the record LSD Radix Sort with de-randomized write memory accesses
+	// Whole records are moved through the de-randomization buffers, with the digit extracted from the key of each record
+	template< unsigned PowerOfTwoRadix, class _Record, class _KeyFunction >
+	inline void _RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedRecords(
+		const _Record* inputArray, _Record* outputArray, size_t q, size_t** startOfBin, size_t startIndex, size_t endIndex, _KeyFunction getKey,
+		unsigned shiftRightAmount, size_t** bufferIndex, _Record** bufferDerandomize, size_t* bufferIndexEnd, size_t BufferDepth)
+	{
+		const size_t NumberOfBins = PowerOfTwoRadix;
+		const size_t mask = PowerOfTwoRadix - 1;
+		size_t*  startOfBinLoc        = startOfBin[q];
+		size_t*  bufferIndexLoc       = bufferIndex[q];
+		_Record* bufferDerandomizeLoc = bufferDerandomize[q];
+
+		for (size_t currIndex = startIndex; currIndex < endIndex; currIndex++)
+		{
+			size_t currDigit = (size_t)(radix_key_to_unsigned(getKey(inputArray[currIndex])) >> shiftRightAmount) & mask;
+			if (bufferIndexLoc[currDigit] < bufferIndexEnd[currDigit])
+			{
+				bufferDerandomizeLoc[bufferIndexLoc[currDigit]++] = inputArray[currIndex];
 			}
-			if (quanta > numberOfFullQuantas)      // last partially filled workQuanta
+			else
 			{
-				size_t startIndex = q * ParallelWorkQuantum;
-				size_t   endIndex = inputSize;									// non-inclusive
-				_RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew<PowerOfTwoRadix, Log2ofPowerOfTwoRadix, BufferDepth>(
-					inputArray, workArray, q, startOfBin, startIndex, endIndex, bitMask, shiftRightAmount, bufferIndex, bufferDerandomize, bufferIndexEnd);
+				size_t outIndex  = startOfBinLoc[currDigit];
+				size_t buffIndex = currDigit * BufferDepth;
+				memcpy(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffIndex]), BufferDepth * sizeof(_Record));
+				startOfBinLoc[currDigit] += BufferDepth;
+				bufferDerandomizeLoc[buffIndex] = inputArray[currIndex];
+				bufferIndexLoc[currDigit] = buffIndex + 1;
 			}
-#else
-		// Multi-core version of the algorithm
+		}
+		// Flush all the derandomization buffers
+		for (size_t whichBuff = 0; whichBuff < NumberOfBins; whichBuff++)
+		{
+			size_t outIndex       = startOfBinLoc[whichBuff];
+			size_t buffStartIndex = whichBuff * BufferDepth;
+			size_t numItems       = bufferIndexLoc[whichBuff] - buffStartIndex;
+			memcpy(&(outputArray[outIndex]), &(bufferDerandomizeLoc[buffStartIndex]), numItems * sizeof(_Record));
+			bufferIndexLoc[whichBuff] = buffStartIndex;
+		}
+	}
+
+	// Body of SortRadixRecordsInnerPar, with counts of _CountType - 32-bit when the work quanta allows it
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Record, class _KeyFunction, class _CountType >
+	inline void _SortRadixRecordsInnerPar(_Record* inputArray, _Record* workArray, size_t inputSize, _KeyFunction getKey, size_t ParallelWorkQuantum, RadixSortWorkspace& workspace)
+	{
+		typedef typename std::decay< decltype(getKey(*inputArray)) >::type _KeyType;
+		const size_t NumberOfBins = PowerOfTwoRadix;
+		const unsigned NumberOfDigits = (unsigned)(sizeof(_KeyType) * 8 / Log2ofPowerOfTwoRadix);
+		if (inputSize == 0)
+			return;
+		size_t quanta = (inputSize % ParallelWorkQuantum) == 0 ? inputSize / ParallelWorkQuantum
+			: inputSize / ParallelWorkQuantum + 1;
+		size_t numberOfFullQuantas = inputSize / ParallelWorkQuantum;
+
+		// Setup de-randomization buffers for writes during the permutation phase
+		// 256 bytes per bin (e.g. 16 records of 16-bytes, 4 records of 64-bytes) keeps the buffers of each work quanta at 64 KBytes, which fit in L2 cache
+		const size_t BufferDepth = (std::max)((size_t)1, (size_t)256 / sizeof(_Record));
+		_Record** bufferDerandomize = workspace.bin_buffers< _Record >(quanta, NumberOfBins, BufferDepth);
+		size_t**  bufferIndex       = workspace.buffer_index_table(quanta, NumberOfBins);
+		for (size_t q = 0; q < quanta; q++)
+			for (size_t b = 0; b < NumberOfBins; b++)
+				bufferIndex[q][b] = b * BufferDepth;
+		size_t* bufferIndexEnd = workspace.buffer_index_end(NumberOfBins);	// non-inclusive
+		for (size_t b = 0; b < NumberOfBins; b++)
+			bufferIndexEnd[b] = (b + 1) * BufferDepth;
+		// End of de-randomization buffers setup
+
+		_CountType** count      = workspace.count_table< _CountType >(quanta, NumberOfBins);
+		size_t**     startOfBin = workspace.start_of_bin_table(        quanta, NumberOfBins);
+
+		unsigned shiftRightAmount = 0;
+		for (unsigned digit = 0; digit < NumberOfDigits; digit++)
+		{
 #if defined(USE_PPL)
 			Concurrency::task_group g;
 #else
 			tbb::task_group g;
 #endif
-			//const auto startTime_1 = high_resolution_clock::now();
-			for (q = 0; q < numberOfFullQuantas; q++)
+			for (size_t q = 0; q < quanta; q++)
 			{
 				size_t startIndex = q * ParallelWorkQuantum;
-				size_t   endIndex = startIndex + ParallelWorkQuantum;	// non-inclusive
-				g.run([=] {																// important to not pass by reference, as all tasks will then get the same/last value
-					_RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(
-						inputArray, workArray, q, startOfBin, startIndex, endIndex, PowerOfTwoRadix - 1, shiftRightAmount, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth);
+				size_t   endIndex = q < numberOfFullQuantas ? startIndex + ParallelWorkQuantum : inputSize;	// non-inclusive
+				g.run([=] {
+					_RadixSortLSD_HistogramRecordsDigit<PowerOfTwoRadix>(inputArray, startIndex, endIndex, getKey, shiftRightAmount, count[q]);
 					});
 			}
-			if (quanta > numberOfFullQuantas)      // last partially filled workQuantum
+			g.wait();
+
+			ComputeStartOfBinsFromCounts<PowerOfTwoRadix>(count, quanta, startOfBin);
+
+			for (size_t q = 0; q < quanta; q++)
 			{
 				size_t startIndex = q * ParallelWorkQuantum;
-				size_t   endIndex = inputSize;									// non-inclusive
-				g.run([=] {
-					_RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedNew<PowerOfTwoRadix, Log2ofPowerOfTwoRadix>(
-						inputArray, workArray, q, startOfBin, startIndex, endIndex, PowerOfTwoRadix - 1, shiftRightAmount, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth);
+				size_t   endIndex = q < numberOfFullQuantas ? startIndex + ParallelWorkQuantum : inputSize;	// non-inclusive
+				g.run([=] {																// important to not pass by reference, as all tasks will then get the same/last value
+					_RadixSortLSD_StableUnsigned_PowerOf2Radix_PermuteDerandomizedRecords<PowerOfTwoRadix>(
+						inputArray, workArray, q, startOfBin, startIndex, endIndex, getKey, shiftRightAmount, bufferIndex, bufferDerandomize, bufferIndexEnd, BufferDepth);
 					});
 			}
 			g.wait();
-			//const auto endTime_1 = high_resolution_clock::now();
-			//print_results("Parallel Radix Sort LSD/PermuteDerandomizeNew: ", startTime_1, endTime_1);
-#endif
-			bitMask <<= Log2ofPowerOfTwoRadix;
-			digit++;
-			shiftRightAmount += Log2ofPowerOfTwoRadix;
-			outputArrayHasResult = !outputArrayHasResult;
-
-			unsigned* tmp = inputArray;       // swap input and output arrays
-			inputArray = workArray;
-			workArray = tmp;
 
-			for (q = 0; q < quanta; q++)
-				delete[] startOfBin[q];
-			delete[] startOfBin;
+			shiftRightAmount += Log2ofPowerOfTwoRadix;
+			std::swap(inputArray, workArray);
 		}
-		//	if (outputArrayHasResult)
-		//		for (unsigned long current = 0; current < inputSize; current++)		// copy from output array into the input array
-		//			inputArray[current] = workArray[current];						// TODO: memcpy will most likely be faster
-		//::operator delete[](bufferIndexEnd, std::align_val_t{ 64 });
-		::operator delete[](bufferIndexEnd, std::align_val_t{ 64 });
+	}
 
-		for (size_t q = 0; q < quanta; q++)
-			::operator delete[](bufferIndex[q], std::align_val_t{ 64 });
-		::operator delete[](bufferIndex, std::align_val_t{ 64 });
+	// Record version of SortRadixInnerPar. Sorts records by the key returned by getKey(record), which is a 32-bit or 64-bit
+	// unsigned, signed integer or floating-point value, leaving the result in inputArray (even number of digits).
+	// De-randomization buffers and count tables come from the workspace, which is reused across calls without allocating.
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Record, class _KeyFunction >
+	inline void SortRadixRecordsInnerPar(_Record* inputArray, _Record* workArray, size_t inputSize, _KeyFunction getKey, size_t ParallelWorkQuantum, RadixSortWorkspace& workspace)
+	{
+		if (ParallelWorkQuantum <= UINT32_MAX)
+			_SortRadixRecordsInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Record, _KeyFunction, uint32_t >(inputArray, workArray, inputSize, getKey, ParallelWorkQuantum, workspace);
+		else
+			_SortRadixRecordsInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Record, _KeyFunction, size_t   >(inputArray, workArray, inputSize, getKey, ParallelWorkQuantum, workspace);
+	}
 
-		for (size_t q = 0; q < quanta; q++)
-			::operator delete[](bufferDerandomize[q], std::align_val_t{ 64 });
-		::operator delete[](bufferDerandomize, std::align_val_t{ 64 });
+	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, class _Record, class _KeyFunction >
+	inline void SortRadixRecordsInnerPar(_Record* inputArray, _Record* workArray, size_t inputSize, _KeyFunction getKey, size_t ParallelWorkQuantum = 64 * 1024)
+	{
+		RadixSortWorkspace workspace;
+		SortRadixRecordsInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(inputArray, workArray, inputSize, getKey, ParallelWorkQuantum, workspace);
 	}
 
-	// LSD Radix Sort - stable (LSD has to be, and this may preclude LSD Radix from being able to be in-place)
-	// Result is returned in "a", whereas "b" is used a temporary working buffer.
-	inline void SortRadixPar(unsigned* a, size_t a_size, size_t parallelThreshold = 64 * 1024)
+	// LSD Radix Sort of records/structs, ordered by the key returned by getKey(record) (e.g. [](const Trade& t) { return t.ts; }) - stable
+	// Records are trivially copyable (e.g. 16 to 64 bytes). Keys are 32-bit or 64-bit unsigned, signed integer or floating-point values.
+	// Whole records are moved through the de-randomization buffers, instead of extracting keys, sorting indexes and then gathering records,
+	// which saves 2-3 passes over memory. Result is returned in "a", with tmp_work_buff used as a temporary working buffer.
+	template< class _Record, class _KeyFunction >
+	inline void SortRadixRecordsPar(_Record* a, _Record* tmp_work_buff, size_t a_size, _KeyFunction getKey, size_t parallelThreshold = 512 * 1024)
 	{
+		typedef typename std::decay< decltype(getKey(*a)) >::type _KeyType;
+		static_assert(std::is_trivially_copyable<_Record>::value, "SortRadixRecordsPar: records must be trivially copyable");
+		static_assert(std::is_arithmetic<_KeyType>::value && (sizeof(_KeyType) == 4 || sizeof(_KeyType) == 8), "SortRadixRecordsPar: only 32-bit and 64-bit keys are supported");
 		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
-		const unsigned long PowerOfTwoRadix = 256;
-		const unsigned long Log2ofPowerOfTwoRadix = 8;
-
-		unsigned* b = new unsigned[a_size];		// this allocation does slow things down a bit. If we want even faster, then pass "b" in as an argument
-
-		// may return 0 when not able to detect
-		auto processor_count = std::thread::hardware_concurrency();
-		//printf("Number of cores = %u \n", processor_count);
-		processor_count *= 4;									// Increase the number of cores to split array into more pieces than cores, which increases performance
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
 
-		if ((processor_count > 0) && (parallelThreshold * processor_count) < a_size)
-			parallelThreshold = a_size / processor_count;
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold, 1);		// one piece per core
 
-		// The beauty of using template arguments instead of function parameters for the Threshold and Log2ofPowerOfTwoRadix is
-		// they are not pushed on the stack and are treated as constants, but local.
 		if (a_size >= Threshold)
-			SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, b, a_size, parallelThreshold);
+			SortRadixRecordsInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, tmp_work_buff, a_size, getKey, parallelThreshold);
 		else
-			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
-
-		delete[] b;
+			insertionSortByKeyFunction(a, a_size, [getKey](const _Record& r) { return radix_key_to_unsigned(getKey(r)); });
 	}
 
-	// Faster implementation, when the user is willing to provide a pre-alocated temporary/working buffer, which makes it a bit more cumbersome to use
-	inline void SortRadixPar(unsigned* a, unsigned* tmp_work_buff, size_t a_size, size_t parallelThreshold = 512 * 1024)
+	// LSD Radix Sort of records/structs, ordered by the key returned by getKey(record) - stable, allocating its own temporary working buffer
+	template< class _Record, class _KeyFunction >
+	inline void SortRadixRecordsPar(_Record* a, size_t a_size, _KeyFunction getKey, size_t parallelThreshold = 64 * 1024)
 	{
+		typedef typename std::decay< decltype(getKey(*a)) >::type _KeyType;
+		static_assert(std::is_trivially_copyable<_Record>::value, "SortRadixRecordsPar: records must be trivially copyable");
+		static_assert(std::is_arithmetic<_KeyType>::value && (sizeof(_KeyType) == 4 || sizeof(_KeyType) == 8), "SortRadixRecordsPar: only 32-bit and 64-bit keys are supported");
 		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
 		const unsigned PowerOfTwoRadix = 256;
 		const unsigned Log2ofPowerOfTwoRadix = 8;
+		if (a_size < Threshold)
+		{
+			SortRadixRecordsPar(a, (_Record*)NULL, a_size, getKey);
+			return;
+		}
+		_Record* b = allocate_working_buffer< _Record >(a_size);
 
-		// may return 0 when not able to detect
-		auto processor_count = std::thread::hardware_concurrency();
-		//printf("Number of cores = %u \n", processor_count);
-		//processor_count = 16;
+		parallelThreshold = _SortRadixParWorkQuantum(a_size, parallelThreshold);
 
-		if ((processor_count > 0) && (parallelThreshold * processor_count) < a_size)
-			parallelThreshold = a_size / processor_count;
+		SortRadixRecordsInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, b, a_size, getKey, parallelThreshold);	// not through the overload above, which clamps to one work quanta per core
 
-		// The beauty of using template arguments instead of function parameters for the Threshold and Log2ofPowerOfTwoRadix is
-		// they are not pushed on the stack and are treated as constants, but local.
-		if (a_size >= Threshold)
-			SortRadixInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, tmp_work_buff, a_size, parallelThreshold);
-		else
-			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);	// TODO: Replace with Parallel Merge Sort to use a bigger Threshold, such at parallelThreshold
+		free_working_buffer(b, a_size);
+	}
+
+	// LSD Radix Sort of records/structs, ordered by the key returned by getKey(record) - stable, with the temporary working buffer and all other
+	// working memory coming from a reusable workspace
+	template< class _Record, class _KeyFunction >
+	inline void SortRadixRecordsPar(_Record* a, size_t a_size, _KeyFunction getKey, RadixSortWorkspace& workspace, size_t parallelThreshold = 64 * 1024)
+	{
+		typedef typename std::decay< decltype(getKey(*a)) >::type _KeyType;
+		static_assert(std::is_trivially_copyable<_Record>::value, "SortRadixRecordsPar: records must be trivially copyable");
+		static_assert(std::is_arithmetic<_KeyType>::value && (sizeof(_KeyType) == 4 || sizeof(_KeyType) == 8), "SortRadixRecordsPar: only 32-bit and 64-bit keys are supported");
+		const size_t Threshold = 100;	// Threshold of when to switch to using Insertion Sort
+		const unsigned PowerOfTwoRadix = 256;
+		const unsigned Log2ofPowerOfTwoRadix = 8;
+
+		if (a_size < Threshold)
+		{
+			insertionSortByKeyFunction(a, a_size, [getKey](const _Record& r) { return radix_key_to_unsigned(getKey(r)); });
+			return;
+		}
+		SortRadixRecordsInnerPar< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, workspace.work_buffer< _Record >(a_size), a_size, getKey, _SortRadixParWorkQuantum(a_size, parallelThreshold), workspace);
 	}
 
 	template< class _CountType >
@@ -405,21 +1324,7 @@ namespace ParallelAlgorithms
 		// Method that performs the core work of counting
 		void operator()(const blocked_range< size_t >& r)
 		{
-			unsigned* a = my_input_array;		// these local variables are used to help the compiler optimize the code better
-			size_t         end = r.end();
-			_CountType(*count)[NumberOfBins] = my_count;
-			_CountType* count0 = count[0];
-			_CountType* count1 = count[1];
-			_CountType* count2 = count[2];
-			_CountType* count3 = count[3];
-			for (size_t i = r.begin(); i != end; ++i)
-			{
-				unsigned value = a[i];
-				count0[value         & 0xff]++;
-				count1[(value >>  8) & 0xff]++;
-				count2[(value >> 16) & 0xff]++;
-				count3[(value >> 24) & 0xff]++;
-			}
+			HistogramByteComponentsMulti(my_input_array, r.begin(), r.end(), my_count[0], my_count[1], my_count[2], my_count[3]);
 		}
 		// Splitter (splitting constructor) required by the parallel_reduce
 		// Takes a reference to the original object, and a dummy argument to distinguish this method from a copy constructor
@@ -4,6 +4,10 @@
 
 #include "RadixSortCommon.h"
 #include "InsertionSort.h"
+#include "CacheInfo.h"
+
+#include <stddef.h>
+#include <algorithm>
 
 // Swap that does not check for self-assignment.
 template< class _Type >
@@ -14,6 +18,104 @@ inline void _swap(_Type& a, _Type& b)
 	b = tmp;
 }
 
+// In-place permutation of one MSD Radix Sort digit, with swap cycles directly within the array (American Flag Sort).
+// startOfBin has a sentinal of 0 at startOfBin[PowerOfTwoRadix]. endOfBin starts out equal to startOfBin, and ends up at the end of each bin.
+template< class _Type, unsigned long PowerOfTwoRadix >
+inline void _RadixSortMSD_PermuteInPlace(_Type* a, size_t a_size, const size_t* startOfBin, size_t* endOfBin, _Type bitMask, unsigned long shiftRightAmount)
+{
+	size_t last = a_size - 1, nextBin = 1;
+	for (size_t _current = 0; _current <= last; )
+	{
+		unsigned digit;
+		_Type _current_element = a[_current];	// get the compiler to recognize that a register can be used for the loop instead of a[_current] memory location
+		while (endOfBin[digit = (unsigned)((_current_element & bitMask) >> shiftRightAmount)] != _current)  _swap(_current_element, a[endOfBin[digit]++]);
+		a[_current] = _current_element;
+
+		endOfBin[digit]++;
+		while (endOfBin[nextBin - 1] == startOfBin[nextBin])  nextBin++;	// skip over empty and full bins, when the end of the current bin reaches the start of the next bin
+		_current = endOfBin[nextBin - 1];
+	}
+}
+
+// Arrays of at least this many bytes are permuted by _RadixSortMSD_PermuteInPlaceBuffered. Smaller ones fit in the L2 cache, where unbuffered swaps are faster.
+inline size_t BufferedPermuteMinimumBytes()
+{
+	return ParallelAlgorithms::CacheSizeL2() / 2;
+}
+
+// In-place permutation of one MSD Radix Sort digit, with de-randomized reads and writes, which moves every element of a[0 .. a_size-1] into its bin,
+// with bin i being [startOfBin[i], startOfBin[i+1]). Same swap cycles as the unbuffered permutation, with all of the swaps happening within cache-resident buffers:
+// each bin has a read buffer, filled with the next BufferDepth elements of that bin, and a write buffer, which is written out to the bin when full.
+// Writes only go to locations of a bin that have already been read into its read buffer. Bins are accessed a cache line at a time, instead of an element
+// at a time, which avoids data-dependent thrashing of cache lines and TLB entries of 256 bins. Buffers of 256 bins take 2 * 256 * BufferDepth * sizeof(_Type) bytes of stack.
+// _KeyPass::key_in is applied to each element as it is read, before its digit is extracted, and _KeyPass::key_out as it is written, since each element is read and written exactly once.
+template< class _Type, unsigned long PowerOfTwoRadix, unsigned long BufferDepth, class _KeyPass = RadixKeyIdentity >
+inline void _RadixSortMSD_PermuteInPlaceBuffered(_Type* a, size_t a_size, const size_t* startOfBin, _Type bitMask, unsigned long shiftRightAmount)
+{
+	const unsigned long NumberOfBins = PowerOfTwoRadix;
+	alignas(64) _Type readBuffer[ NumberOfBins][BufferDepth];
+	alignas(64) _Type writeBuffer[NumberOfBins][BufferDepth];
+	size_t readIndex[NumberOfBins], readCount[NumberOfBins], writeCount[NumberOfBins];
+	size_t readEnd[NumberOfBins], writeEnd[NumberOfBins], endOfBin[NumberOfBins];	// elements of a bin before readEnd have been read, and before writeEnd written
+
+	for (unsigned long i = 0; i < NumberOfBins; i++)
+	{
+		readEnd[i] = writeEnd[i] = startOfBin[i];
+		endOfBin[i] = i + 1 < NumberOfBins ? startOfBin[i + 1] : a_size;
+		readIndex[i] = readCount[i] = writeCount[i] = 0;
+	}
+	// Next element of a bin, which has not been moved yet
+	auto read = [&](unsigned long digit) -> _Type
+	{
+		if (readIndex[digit] == readCount[digit])
+		{
+			size_t numberOfElements = (std::min)((size_t)BufferDepth, endOfBin[digit] - readEnd[digit]);
+			_Type* inBin = a + readEnd[digit];
+			for (size_t j = 0; j < numberOfElements; j++)
+				readBuffer[digit][j] = _KeyPass::key_in(inBin[j]);
+			readEnd[digit]  += numberOfElements;
+			readCount[digit] = numberOfElements;
+			readIndex[digit] = 0;
+		}
+		return readBuffer[digit][readIndex[digit]++];
+	};
+	// Moves an element into its bin. Bin locations up to readEnd are free, as each element written was preceded by an element read from the same bin
+	auto write = [&](unsigned long digit, _Type element)
+	{
+		writeBuffer[digit][writeCount[digit]++] = element;
+		if (writeCount[digit] == BufferDepth)
+		{
+			_Type* outBin = a + writeEnd[digit];
+			for (size_t j = 0; j < BufferDepth; j++)
+				outBin[j] = _KeyPass::key_out(writeBuffer[digit][j]);
+			writeEnd[digit]  += BufferDepth;
+			writeCount[digit] = 0;
+		}
+	};
+
+	for (unsigned long startBin = 0; startBin < NumberOfBins; startBin++)
+	{
+		while (readIndex[startBin] < readCount[startBin] || readEnd[startBin] < endOfBin[startBin])	// elements of this bin which have not been moved yet
+		{
+			_Type _current_element = read(startBin);		// start of a swap cycle, which ends with an element of startBin
+			unsigned long digit;
+			while ((digit = (unsigned long)((_current_element & bitMask) >> shiftRightAmount)) != startBin)
+			{
+				_Type _next_element = read(digit);		// read before writing, which frees a location of the bin for the write
+				write(digit, _current_element);
+				_current_element = _next_element;
+			}
+			write(startBin, _current_element);
+		}
+	}
+	for (unsigned long i = 0; i < NumberOfBins; i++)	// flush the rest of write buffers, which fill up their bins
+	{
+		_Type* outBin = a + writeEnd[i];
+		for (size_t j = 0; j < writeCount[i]; j++)
+			outBin[j] = _KeyPass::key_out(writeBuffer[i][j]);
+	}
+}
+
 // Simplified the implementation of the inner loop.
 template< class _Type, unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, long Threshold >
 inline void _RadixSort_Unsigned_PowerOf2Radix_L1(_Type* a, size_t a_size, _Type bitMask, unsigned long shiftRightAmount)
@@ -24,22 +126,20 @@ inline void _RadixSort_Unsigned_PowerOf2Radix_L1(_Type* a, size_t a_size, _Type
 	for (size_t _current = 0; _current <= last; _current++)	    // Scan the array and count the number of times each value appears
 		count[(unsigned)((a[_current] & bitMask) >> shiftRightAmount)]++;
 
-	size_t startOfBin[PowerOfTwoRadix + 1], endOfBin[PowerOfTwoRadix], nextBin = 1;
+	size_t startOfBin[PowerOfTwoRadix + 1], endOfBin[PowerOfTwoRadix];
 	startOfBin[0] = endOfBin[0] = 0;    startOfBin[PowerOfTwoRadix] = 0;			// sentinal
 	for (unsigned long i = 1; i < PowerOfTwoRadix; i++)
 		startOfBin[i] = endOfBin[i] = startOfBin[i - 1] + count[i - 1];
 
-	for (size_t _current = 0; _current <= last; )
+	if (a_size * sizeof(_Type) >= BufferedPermuteMinimumBytes())		// arrays that don't fit in the cache benefit from de-randomized accesses to the bins
 	{
-		unsigned digit;
-		_Type _current_element = a[_current];	// get the compiler to recognize that a register can be used for the loop instead of a[_current] memory location
-		while (endOfBin[digit = (unsigned)((_current_element & bitMask) >> shiftRightAmount)] != _current)  _swap(_current_element, a[endOfBin[digit]++]);
-		a[_current] = _current_element;
-
-		endOfBin[digit]++;
-		while (endOfBin[nextBin - 1] == startOfBin[nextBin])  nextBin++;	// skip over empty and full bins, when the end of the current bin reaches the start of the next bin
-		_current = endOfBin[nextBin - 1];
+		_RadixSortMSD_PermuteInPlaceBuffered< _Type, PowerOfTwoRadix, 64 / sizeof(_Type) >(a, a_size, startOfBin, bitMask, shiftRightAmount);
+		for (unsigned long i = 0; i < PowerOfTwoRadix; i++)
+			endOfBin[i] = i + 1 < PowerOfTwoRadix ? startOfBin[i + 1] : a_size;
 	}
+	else
+		_RadixSortMSD_PermuteInPlace< _Type, PowerOfTwoRadix >(a, a_size, startOfBin, endOfBin, bitMask, shiftRightAmount);
+
 	bitMask >>= Log2ofPowerOfTwoRadix;
 	if (bitMask != 0)						// end recursion when all the bits have been processes
 	{
@@ -82,6 +182,26 @@ inline void hybrid_inplace_msd_radix_sort(unsigned* a, size_t a_size)
 		//insertionSortHybrid(a, a_size);
 }
 
+// In-place MSD Radix Sort of 64-bit unsigned keys - not stable
+template< class _Type >
+inline void hybrid_inplace_msd_radix_sort(_Type* a, size_t a_size)
+{
+	static_assert(std::is_unsigned<_Type>::value && sizeof(_Type) == 8, "hybrid_inplace_msd_radix_sort: only 64-bit unsigned keys are supported by this overload, with 32-bit keys sorted by the unsigned overload");
+	if (a_size < 2)	return;
+
+	const long PowerOfTwoRadix = 256;
+	const long Log2ofPowerOfTwoRadix = 8;
+	const long Threshold = 48;
+
+	unsigned long shiftRightAmount = sizeof(_Type) * 8 - Log2ofPowerOfTwoRadix;
+	_Type bitMask = (_Type)((_Type)(PowerOfTwoRadix - 1) << shiftRightAmount);	// top digit
+
+	if (a_size >= Threshold)
+		_RadixSort_Unsigned_PowerOf2Radix_L1< _Type, PowerOfTwoRadix, Log2ofPowerOfTwoRadix, Threshold >(a, a_size, bitMask, shiftRightAmount);
+	else
+		insertionSortSimilarToSTLnoSelfAssignment( a, a_size );
+}
+
 template< unsigned PowerOfTwoRadix, unsigned Log2ofPowerOfTwoRadix, size_t Threshold, class _Type >
 inline void _RadixSort_StableUnsigned_PowerOf2Radix_2(_Type* a, _Type* b, size_t last, _Type bitMask, unsigned shiftRightAmount, bool inputArrayIsDestination)
 {
@@ -7,6 +7,7 @@
 #include <ratio>
 #include <vector>
 #include <execution>
+#include <thread>
 
 #include "RadixSortMSD.h"
 #include "RadixSortMsdParallel.h"
@@ -70,3 +71,117 @@ int RadixSortMsdBenchmark(vector<unsigned>& uints)
 
 	return 0;
 }
+
+// Top digit permutation of the in-place MSD Radix Sort: a single core (American flag sort) vs. all cores (speculative permutation and repair),
+// followed by the whole parallel in-place sort, which permutes the top levels with all cores
+int ParallelInPlaceMsdPermuteBenchmark(vector<unsigned>& uints)
+{
+	const unsigned long PowerOfTwoRadix = 256;
+	const unsigned      shiftRightAmount = 24;
+	const unsigned      bitMask = 0xff000000;
+	size_t numberOfThreads = std::thread::hardware_concurrency();
+
+	vector<unsigned> uintsCopy(uints);
+	vector<unsigned> sorted_reference(uints);
+	sort(std::execution::par_unseq, sorted_reference.begin(), sorted_reference.end());
+
+	size_t count[PowerOfTwoRadix] = {}, startOfBin[PowerOfTwoRadix];
+	for (size_t j = 0; j < uints.size(); j++)
+		count[(uints[j] & bitMask) >> shiftRightAmount]++;
+	startOfBin[0] = 0;
+	for (unsigned long i = 1; i < PowerOfTwoRadix; i++)
+		startOfBin[i] = startOfBin[i - 1] + count[i - 1];
+
+	printf("\n%zu unsigned integers, %zu cores\n", uints.size(), numberOfThreads);
+	for (size_t threads : { (size_t)1, numberOfThreads })
+	{
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			std::copy(uints.begin(), uints.end(), uintsCopy.begin());
+			const auto startTime = high_resolution_clock::now();
+			ParallelAlgorithms::_RadixSortMSD_PermuteInPlacePar< unsigned, PowerOfTwoRadix, RadixKeyIdentity >(uintsCopy.data(), uintsCopy.size(), startOfBin, bitMask, shiftRightAmount, threads);
+			const auto endTime = high_resolution_clock::now();
+			printf("Top digit in-place permutation with %zu threads: %fms\n", threads, duration_cast<duration<double, milli>>(endTime - startTime).count());
+		}
+	}
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		std::copy(uints.begin(), uints.end(), uintsCopy.begin());
+		const auto startTime = high_resolution_clock::now();
+		ParallelAlgorithms::parallel_hybrid_inplace_msd_radix_sort(uintsCopy.data(), uintsCopy.size());
+		const auto endTime = high_resolution_clock::now();
+		print_results("Parallel In-Place Radix Sort MSD", uintsCopy, uints.size(), startTime, endTime);
+
+		if (!std::equal(sorted_reference.begin(), sorted_reference.end(), uintsCopy.begin()))
+		{
+			printf("Arrays are not equal\n");
+			exit(1);
+		}
+	}
+	return 0;
+}
+
+// Top digit in-place permutation with swap cycles directly within the array vs. within cache-resident read/write buffers of each bin,
+// followed by the whole single-core in-place MSD Radix Sort, which uses the buffered permutation for arrays larger than the cache
+template< class _Type >
+static void InPlaceMsdBufferedPermuteBenchmark(const vector<_Type>& keys, const char* keyName)
+{
+	const unsigned long PowerOfTwoRadix = 256;
+	const unsigned long shiftRightAmount = sizeof(_Type) * 8 - 8;
+	const _Type bitMask = (_Type)((_Type)(PowerOfTwoRadix - 1) << shiftRightAmount);
+
+	vector<_Type> keysCopy(keys);
+	vector<_Type> sorted_reference(keys);
+	sort(std::execution::par_unseq, sorted_reference.begin(), sorted_reference.end());
+
+	size_t count[PowerOfTwoRadix] = {}, startOfBin[PowerOfTwoRadix + 1], endOfBin[PowerOfTwoRadix];
+	for (size_t j = 0; j < keys.size(); j++)
+		count[(keys[j] & bitMask) >> shiftRightAmount]++;
+	startOfBin[0] = 0;    startOfBin[PowerOfTwoRadix] = 0;			// sentinal
+	for (unsigned long i = 1; i < PowerOfTwoRadix; i++)
+		startOfBin[i] = startOfBin[i - 1] + count[i - 1];
+
+	printf("\n%zu %s keys\n", keys.size(), keyName);
+	for (int buffered = 0; buffered < 2; buffered++)
+	{
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			std::copy(keys.begin(), keys.end(), keysCopy.begin());
+			std::copy(startOfBin, startOfBin + PowerOfTwoRadix, endOfBin);
+			const auto startTime = high_resolution_clock::now();
+			if (buffered)
+				_RadixSortMSD_PermuteInPlaceBuffered< _Type, PowerOfTwoRadix, 64 / sizeof(_Type) >(keysCopy.data(), keysCopy.size(), startOfBin, bitMask, shiftRightAmount);
+			else
+				_RadixSortMSD_PermuteInPlace< _Type, PowerOfTwoRadix >(keysCopy.data(), keysCopy.size(), startOfBin, endOfBin, bitMask, shiftRightAmount);
+			const auto endTime = high_resolution_clock::now();
+			double milliseconds = duration_cast<duration<double, milli>>(endTime - startTime).count();
+			printf("Top digit in-place permutation, %s: %fms  %.1f million keys/second\n", buffered ? "buffered" : "unbuffered", milliseconds, keys.size() / milliseconds / 1000.0);
+		}
+	}
+	for (int i = 0; i < iterationCount; ++i)
+	{
+		std::copy(keys.begin(), keys.end(), keysCopy.begin());
+		const auto startTime = high_resolution_clock::now();
+		hybrid_inplace_msd_radix_sort(keysCopy.data(), keysCopy.size());
+		const auto endTime = high_resolution_clock::now();
+		double milliseconds = duration_cast<duration<double, milli>>(endTime - startTime).count();
+		printf("In-Place Radix Sort MSD: %fms  %.1f million keys/second\n", milliseconds, keys.size() / milliseconds / 1000.0);
+
+		if (!std::equal(sorted_reference.begin(), sorted_reference.end(), keysCopy.begin()))
+		{
+			printf("Arrays are not equal\n");
+			exit(1);
+		}
+	}
+}
+
+int InPlaceMsdBufferedPermuteBenchmark(vector<unsigned>& uints)
+{
+	InPlaceMsdBufferedPermuteBenchmark(uints, "32-bit");
+
+	vector<unsigned long long> ulongs(uints.size());
+	for (size_t j = 0; j < uints.size(); j++)
+		ulongs[j] = ((unsigned long long)uints[j] << 32) | uints[uints.size() - 1 - j];
+	InPlaceMsdBufferedPermuteBenchmark(ulongs, "64-bit");
+	return 0;
+}
@@ -28,10 +28,107 @@ using namespace tbb;
 
 namespace ParallelAlgorithms
 {
+	// Parallel in-place permutation of one digit of MSD Radix Sort, which moves every element of a[0 .. size-1] into its bin, with bin i being [startOfBin[i], startOfBin[i+1])
+	// Speculative permutation followed by repair (PARADIS, Cho et al., VLDB 2015), in rounds:
+	//   Permute - the unfinished part of each bin is split into equal stripes, one per thread. Each thread swaps elements into its own stripe of their bin,
+	//             without synchronization, and leaves an element misplaced when its stripe of that bin is full. Correct elements are gathered at the front of each stripe.
+	//   Repair  - each bin, in parallel, swaps its misplaced elements with correct elements from its end, which leaves all misplaced elements at the end of the bin.
+	// Misplaced elements left at the ends of bins belong to each other's bins, and are permuted by the next round, with fewer threads as fewer elements are left.
+	// A round with a single thread places all of the remaining elements. Uses O(threads * bins) memory, independent of the array size.
+	// Keys are not transformed: _KeyPass::key_in is applied to each key read to extract its digit.
+	template< class _Type, unsigned long PowerOfTwoRadix, class _KeyPass >
+	inline void _RadixSortMSD_PermuteInPlacePar(_Type* a, size_t size, const size_t* startOfBin, _Type bitMask, unsigned long shiftRightAmount,
+		size_t numberOfThreads, size_t minimumPerThread = 64 * 1024)
+	{
+		const unsigned long NumberOfBins = PowerOfTwoRadix;
+		auto digitOf = [=](_Type v) { return (unsigned long)((_KeyPass::key_in(v) & bitMask) >> shiftRightAmount); };
+
+		size_t binHead[NumberOfBins], binTail[NumberOfBins];		// unfinished part of each bin: [binHead, binTail)
+		size_t remaining = 0;
+		for (unsigned long i = 0; i < NumberOfBins; i++)
+		{
+			binHead[i] = startOfBin[i];
+			binTail[i] = i + 1 < NumberOfBins ? startOfBin[i + 1] : size;
+		}
+		std::vector< size_t > stripeHead(numberOfThreads * NumberOfBins), stripeTail(numberOfThreads * NumberOfBins);	// [thread][bin]
+
+		for (unsigned long i = 0; i < NumberOfBins; i++)
+			remaining += binTail[i] - binHead[i];
+		size_t numberOfStripes = (std::min)(numberOfThreads, (std::max)(remaining / minimumPerThread, (size_t)1));
+
+		while (remaining > 0)
+		{
+			for (size_t p = 0; p < numberOfStripes; p++)
+				for (unsigned long i = 0; i < NumberOfBins; i++)
+				{
+					size_t binSize = binTail[i] - binHead[i];
+					stripeHead[p * NumberOfBins + i] = binHead[i] + binSize *  p      / numberOfStripes;
+					stripeTail[p * NumberOfBins + i] = binHead[i] + binSize * (p + 1) / numberOfStripes;
+				}
+			// Speculative permutation: each thread only reads and writes its own stripes
+			tbb::parallel_for(size_t(0), numberOfStripes, [&](size_t p) {
+				size_t* head = &stripeHead[p * NumberOfBins];
+				size_t* tail = &stripeTail[p * NumberOfBins];
+				for (unsigned long i = 0; i < NumberOfBins; i++)
+				{
+					for (size_t current = head[i]; current < tail[i]; current++)
+					{
+						_Type _current_element = a[current];
+						unsigned long digit;
+						while ((digit = digitOf(_current_element)) != i && head[digit] < tail[digit])
+							_swap(_current_element, a[head[digit]++]);
+						if (digit == i)							// gather correct elements at the front of the stripe, and misplaced ones behind them
+						{
+							a[current] = a[head[i]];
+							a[head[i]++] = _current_element;
+						}
+						else
+							a[current] = _current_element;		// stripe of its bin is full
+					}
+				}
+			});
+			// Repair: move correct elements from the end of each bin into the misplaced slots of its stripes
+			tbb::parallel_for(size_t(0), (size_t)NumberOfBins, [&](size_t i) {
+				size_t tail = binTail[i];				// [tail, binTail[i]) holds only misplaced elements
+				for (size_t p = 0; p < numberOfStripes; p++)
+				{
+					size_t stripeEnd = stripeTail[p * NumberOfBins + i];
+					for (size_t current = stripeHead[p * NumberOfBins + i]; current < stripeEnd && current < tail; current++)
+					{
+						while (--tail > current && digitOf(a[tail]) != i) {}
+						if (tail == current)
+							break;
+						_swap(a[current], a[tail]);
+					}
+				}
+				binHead[i] = tail;
+			});
+
+			size_t remainingBefore = remaining;
+			remaining = 0;
+			for (unsigned long i = 0; i < NumberOfBins; i++)
+				remaining += binTail[i] - binHead[i];
+			if (remaining == remainingBefore)		// no progress, which a single thread is guaranteed to make
+				numberOfStripes = 1;
+			else
+				numberOfStripes = (std::min)(numberOfStripes, (std::max)(remaining / minimumPerThread, (size_t)1));
+		}
+	}
+
+	const size_t ParallelPermuteMinimumPerThread = 64 * 1024;	// elements per thread, below which a digit is permuted by a single core
+
 	// Simplified the implementation of the inner loop.
-	template< class _Type, unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, long Threshold >
+	// _Type is any unsigned integer type. _KeyTransform supports signed integer and floating-point keys through their unsigned representation (see RadixKeyTransform):
+	// at the top digit signed keys extract their digit with the sign bit flipped (extractDigitNegate), and floating-point keys are transformed as they are permuted.
+	// Floating-point keys are transformed back at the leaves of the recursion, as they are written by the last digit, or after Insertion Sort while they are in cache.
+	// Large arrays and bins (the top levels of the recursion) are permuted in-place by all cores (see _RadixSortMSD_PermuteInPlacePar), instead of a single core.
+	template< class _Type, unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, long Threshold, class _KeyTransform = RadixKeyTransform< _Type >, bool TopDigit = false >
 	inline void _RadixSort_Unsigned_PowerOf2Radix_Par_L1(_Type* a, size_t a_size, _Type bitMask, unsigned long shiftRightAmount)
 	{
+		typedef typename std::conditional< TopDigit, RadixKeyPass< _KeyTransform, true, true >, RadixKeyIdentity >::type _HistogramKeyPass;	// key_in is the transform at the top digit
+		const bool TransformIn  = TopDigit && _KeyTransform::TransformsBits;
+		const bool NegateDigit  = TopDigit && _KeyTransform::NegatesTopDigit;
+		const bool TransformOut = _KeyTransform::TransformsBits && (bitMask >> Log2ofPowerOfTwoRadix) == 0;	// last digit
 		size_t last = a_size - 1;
 #if 0
 		size_t count[PowerOfTwoRadix];
@@ -40,24 +137,74 @@ namespace ParallelAlgorithms
 		for (size_t _current = 0; _current <= last; _current++)	    // Scan the array and count the number of times each value appears
 			count[(unsigned long)((a[_current] & bitMask) >> shiftRightAmount)]++;
 #else
-		size_t* count = HistogramOneByteComponentParallel< PowerOfTwoRadix, Log2ofPowerOfTwoRadix >(a, 0, last, shiftRightAmount);
+		size_t* count = HistogramOneByteComponentParallel< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, _Type, _HistogramKeyPass >(a, 0, last, shiftRightAmount);
 #endif
 
 		size_t startOfBin[PowerOfTwoRadix + 1], endOfBin[PowerOfTwoRadix], nextBin = 1;
 		startOfBin[0] = endOfBin[0] = 0;    startOfBin[PowerOfTwoRadix] = 0;			// sentinal
 		for (unsigned long i = 1; i < PowerOfTwoRadix; i++)
 			startOfBin[i] = endOfBin[i] = startOfBin[i - 1] + count[i - 1];
+		delete[] count;
+
+		// Large arrays are permuted by all cores in parallel, with keys left in their original representation (transformed by each bin task below)
+		size_t numberOfThreads = _MaxConcurrency();		// limited by the task arena (e.g. tbb::global_control), not only by the cores
+		bool permuteInParallel = !TransformOut && numberOfThreads > 1 && a_size / ParallelPermuteMinimumPerThread >= 2;
+		bool binsUntransformed = permuteInParallel && TransformIn;
+
+		if (permuteInParallel)
+		{
+			_RadixSortMSD_PermuteInPlacePar< _Type, PowerOfTwoRadix, _HistogramKeyPass >(a, a_size, startOfBin, bitMask, shiftRightAmount, numberOfThreads, ParallelPermuteMinimumPerThread);
+			for (unsigned long i = 0; i < PowerOfTwoRadix; i++)
+				endOfBin[i] = i + 1 < PowerOfTwoRadix ? startOfBin[i + 1] : a_size;
+		}
+		else if (a_size * sizeof(_Type) >= BufferedPermuteMinimumBytes())
+		{
+			// Keys are read and written exactly once, which transforms them on the fly: signed top digits are flipped on the way in and back out
+			if (NegateDigit || TransformOut)
+				_RadixSortMSD_PermuteInPlaceBuffered< _Type, PowerOfTwoRadix, 64 / sizeof(_Type), RadixKeyPass< _KeyTransform, TopDigit, true  > >(a, a_size, startOfBin, bitMask, shiftRightAmount);
+			else
+				_RadixSortMSD_PermuteInPlaceBuffered< _Type, PowerOfTwoRadix, 64 / sizeof(_Type), RadixKeyPass< _KeyTransform, TopDigit, false > >(a, a_size, startOfBin, bitMask, shiftRightAmount);
+			for (unsigned long i = 0; i < PowerOfTwoRadix; i++)
+				endOfBin[i] = i + 1 < PowerOfTwoRadix ? startOfBin[i + 1] : a_size;
+		}
+		else if (!TransformIn && !TransformOut)
+		{
+			for (size_t _current = 0; _current <= last; )
+			{
+				unsigned digit;
+				_Type _current_element = a[_current];	// get the compiler to recognize that a register can be used for the loop instead of a[_current] memory location
+				if (NegateDigit)
+					while (endOfBin[digit = (unsigned)extractDigitNegate< PowerOfTwoRadix >(_current_element, bitMask, shiftRightAmount)] != _current)  _swap(_current_element, a[endOfBin[digit]++]);
+				else
+					while (endOfBin[digit = (unsigned)((_current_element & bitMask) >> shiftRightAmount)] != _current)  _swap(_current_element, a[endOfBin[digit]++]);
+				a[_current] = _current_element;
 
-		for (size_t _current = 0; _current <= last; )
+				endOfBin[digit]++;
+				while (endOfBin[nextBin - 1] == startOfBin[nextBin])  nextBin++;	// skip over empty and full bins, when the end of the current bin reaches the start of the next bin
+				_current = endOfBin[nextBin - 1];
+			}
+		}
+		else
 		{
-			unsigned digit;
-			_Type _current_element = a[_current];	// get the compiler to recognize that a register can be used for the loop instead of a[_current] memory location
-			while (endOfBin[digit = (unsigned)((_current_element & bitMask) >> shiftRightAmount)] != _current)  _swap(_current_element, a[endOfBin[digit]++]);
-			a[_current] = _current_element;
-
-			endOfBin[digit]++;
-			while (endOfBin[nextBin - 1] == startOfBin[nextBin])  nextBin++;	// skip over empty and full bins, when the end of the current bin reaches the start of the next bin
-			_current = endOfBin[nextBin - 1];
+			// Every element is written exactly once into its bin, and all reads are from not yet permuted locations, which allows transforming on the fly
+			for (size_t _current = 0; _current <= last; )
+			{
+				unsigned digit;
+				_Type _current_element = a[_current];
+				if (TransformIn)
+					_current_element = _KeyTransform::to_unsigned(_current_element);
+				while (endOfBin[digit = (unsigned)((_current_element & bitMask) >> shiftRightAmount)] != _current)
+				{
+					_Type _next_element = a[endOfBin[digit]];
+					a[endOfBin[digit]++] = TransformOut ? _KeyTransform::from_unsigned(_current_element) : _current_element;
+					_current_element = TransformIn ? _KeyTransform::to_unsigned(_next_element) : _next_element;
+				}
+				a[_current] = TransformOut ? _KeyTransform::from_unsigned(_current_element) : _current_element;
+
+				endOfBin[digit]++;
+				while (endOfBin[nextBin - 1] == startOfBin[nextBin])  nextBin++;	// skip over empty and full bins, when the end of the current bin reaches the start of the next bin
+				_current = endOfBin[nextBin - 1];
+			}
 		}
 
 		bitMask >>= Log2ofPowerOfTwoRadix;
@@ -87,80 +234,25 @@ namespace ParallelAlgorithms
 				size_t numberOfElements = endOfBin[i] - startOfBin[i];
 				if (numberOfElements >= Threshold)		// endOfBin actually points to one beyond the bin
 					g.run([=] {							// important to not pass by reference, as all tasks will then get the same/last value
-					_RadixSort_Unsigned_PowerOf2Radix_Par_L1< _Type, PowerOfTwoRadix, Log2ofPowerOfTwoRadix, Threshold >(&a[startOfBin[i]], numberOfElements, bitMask, shiftRightAmount);
+					if (binsUntransformed)
+						for (size_t j = startOfBin[i]; j < endOfBin[i]; j++)
+							a[j] = _KeyTransform::to_unsigned(a[j]);
+					_RadixSort_Unsigned_PowerOf2Radix_Par_L1< _Type, PowerOfTwoRadix, Log2ofPowerOfTwoRadix, Threshold, _KeyTransform >(&a[startOfBin[i]], numberOfElements, bitMask, shiftRightAmount);
 						});
-				else if (numberOfElements >= 2)
-					insertionSortSimilarToSTLnoSelfAssignment(&a[startOfBin[i]], numberOfElements);
-			}
-			g.wait();
-#endif
-		}
-	}
-
-	// Permute phase of MSD Radix Sort with de-randomized write memory accesses
-	// Derandomizes system memory accesses by buffering all Radix bin accesses, turning 256-bin random memory writes into sequential writes
-	// Separates read pointers from write pointers of/to each bin
-	// Idea: It may be better to implement read/write buffering where all of the swaps happen within those buffers with writes dumping out to the bins and fetching the next buffer
-	//       It's similar to caching, but doing it in a more cache-friendly way where all of the bin-buffers can fit into the cache and not map on top of each other. Otherwise, with
-	//       bins we get data-dependent cache thrashing. Plus, all of the swapping will be within the buffers which are well organized for caching.
-	template< unsigned long PowerOfTwoRadix, unsigned long Log2ofPowerOfTwoRadix, long Threshold, unsigned long BufferDepth>
-	inline void _RadixSortMSD_StableUnsigned_PowerOf2Radix_PermuteDerandomized_1(unsigned long* inout_array, size_t startIndex, size_t endIndex, unsigned long bitMask, unsigned long shiftRightAmount,
-		size_t* startOfBin, size_t* endOfBin, unsigned long bufferIndex[], unsigned long bufferDerandomize[][BufferDepth])
-	{
-		// TODO: This version is broken and needs to be fixed!!
-
-		//printf("Permute Derandomized #1: startIndex = %zu   endIndex = %zu   bitMask = %lx   shiftRight = %lu \n", startIndex, endIndex, bitMask, shiftRightAmount);
-		const unsigned long NumberOfBins = PowerOfTwoRadix;
-		size_t writeEndOfBin[NumberOfBins];									// write pointers to each bin
-		std::copy(endOfBin + 0, endOfBin + NumberOfBins, writeEndOfBin);	// copy read pointers (endOfBin) to write pointers
-
-		size_t nextBin = 1;
-		for (size_t _current = startIndex; _current <= endIndex;)
-		{
-			unsigned long digit;
-			unsigned long _current_element = inout_array[_current];	// get the compiler to recognize that a register can be used for the loop instead of a[_current] memory location
-			while (endOfBin[digit = (unsigned long)((_current_element & bitMask) >> shiftRightAmount)] != _current)
-			{
-				unsigned long tmp = _current_element;				// read of the current element to squirl it away
-				_current_element = inout_array[endOfBin[digit]];	// read from a bin and place in the current element
-				endOfBin[digit]++;									// advance the read pointer of that bin
-
-				//a[endOfBin[digit]] = tmp;							// write the current element to that bin. This is the one (the write) which needs to be buffered
-
-				if (bufferIndex[digit] < BufferDepth)
-				{
-					bufferDerandomize[digit][bufferIndex[digit]++] = tmp;	// write the current element into the buffer for that bin
-				}
 				else
 				{
-					unsigned long outIndex = writeEndOfBin[digit];
-					unsigned long* buff = &(bufferDerandomize[digit][0]);
-#if 1
-					memcpy(&(inout_array[outIndex]), buff, BufferDepth * sizeof(unsigned long));	// significantly faster than a for loop. Need to try std::copy - simpler interface
-#else
-					unsigned long* outBuff = &(output_array[outIndex]);
-					for (unsigned long i = 0; i < BufferDepth; i++)
-						*outBuff++ = *buff++;
-#endif
-					writeEndOfBin[digit] += BufferDepth;
-					bufferDerandomize[digit][0] = tmp;						// write the current element into the buffer for that bin
-					bufferIndex[digit] = 1;
+					if (binsUntransformed)
+						for (size_t j = startOfBin[i]; j < endOfBin[i]; j++)
+							a[j] = _KeyTransform::to_unsigned(a[j]);
+					if (numberOfElements >= 2)
+						insertionSortSimilarToSTLnoSelfAssignment(&a[startOfBin[i]], numberOfElements);
+					if (_KeyTransform::TransformsBits)	// leaf of the recursion: transform floating-point keys back while they are in cache
+						for (size_t j = startOfBin[i]; j < endOfBin[i]; j++)
+							a[j] = _KeyTransform::from_unsigned(a[j]);
 				}
 			}
-			inout_array[_current] = _current_element;	// write the current element into the current bin
-			endOfBin[digit]++;							// advance the read  pointer
-			writeEndOfBin[digit]++;						// advance the write pointer
-
-			while (endOfBin[nextBin - 1] == startOfBin[nextBin])  nextBin++;	// skip over empty and full bins, when the end of the current bin reaches the start of the next bin
-			_current = endOfBin[nextBin - 1];
-		}
-		// Flush all the derandomization buffers
-		for (unsigned long whichBuff = 0; whichBuff < NumberOfBins; whichBuff++)
-		{
-			unsigned long numOfElementsInBuff = bufferIndex[whichBuff];
-			for (size_t i = 0; i < numOfElementsInBuff; i++)
-				inout_array[writeEndOfBin[whichBuff]++] = bufferDerandomize[whichBuff][i];
-			bufferIndex[whichBuff] = 0;
+			g.wait();
+#endif
 		}
 	}
 
@@ -225,32 +317,13 @@ namespace ParallelAlgorithms
 		startOfBin[0] = endOfBin[0] = 0;    startOfBin[PowerOfTwoRadix] = 0;			// sentinal
 		for (unsigned long i = 1; i < PowerOfTwoRadix; i++)
 			startOfBin[i] = endOfBin[i] = startOfBin[i - 1] + count[i - 1];
+		delete[] count;
+
+		// Permute with de-randomized reads and writes, with all of the swaps within cache-resident buffers of each bin
+		_RadixSortMSD_PermuteInPlaceBuffered< unsigned long, PowerOfTwoRadix, 64 / sizeof(unsigned long) >(a, a_size, startOfBin, bitMask, shiftRightAmount);
+		for (unsigned long i = 0; i < PowerOfTwoRadix; i++)
+			endOfBin[i] = i + 1 < PowerOfTwoRadix ? startOfBin[i + 1] : a_size;
 
-#if 1
-		size_t nextBin = 1;
-		for (size_t _current = 0; _current <= last; )
-		{
-			unsigned long digit;
-			unsigned long _current_element = a[_current];	// get the compiler to recognize that a register can be used for the loop instead of a[_current] memory location
-			while (endOfBin[digit = (unsigned long)((_current_element & bitMask) >> shiftRightAmount)] != _current)  _swap(_current_element, a[endOfBin[digit]++]);
-			a[_current] = _current_element;
-
-			endOfBin[digit]++;
-			while (endOfBin[nextBin - 1] == startOfBin[nextBin])  nextBin++;	// skip over empty and full bins, when the end of the current bin reaches the start of the next bin
-			_current = endOfBin[nextBin - 1];
-		}
-#else
-		// TODO: This version is broken and needs to be fixed!!
-		const unsigned long NumberOfBins = PowerOfTwoRadix;
-		static const unsigned long bufferDepth = 128;
-		__declspec(align(64)) unsigned long bufferDerandomize[NumberOfBins][bufferDepth];
-		__declspec(align(64)) unsigned long bufferIndex[NumberOfBins] = { 0 };
-
-		//printf("Before Permute Derandomized \n");
-		_RadixSortMSD_StableUnsigned_PowerOf2Radix_PermuteDerandomized_1< PowerOfTwoRadix, Log2ofPowerOfTwoRadix, Threshold, bufferDepth>(
-			a, 0, last, bitMask, shiftRightAmount, startOfBin, endOfBin, bufferIndex, bufferDerandomize);
-		//printf("After Permute Derandomized \n");
-#endif
 		bitMask >>= Log2ofPowerOfTwoRadix;
 		if (bitMask != 0)						// end recursion when all the bits have been processes
 		{
@@ -315,5 +388,29 @@ namespace ParallelAlgorithms
 			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
 		//insertionSortHybrid(a, a_size);
 	}
+
+	// Parallel in-place MSD Radix Sort of signed integer (int32/int64), floating-point (float/double) and 64-bit unsigned keys - not stable
+	// Sorts the order-preserving unsigned representation of the keys (see RadixKeyTransform), without extra passes over the array
+	template< class _Type >
+	inline void parallel_hybrid_inplace_msd_radix_sort(_Type* a, size_t a_size)
+	{
+		static_assert((std::is_unsigned<_Type>::value && sizeof(_Type) == 8) || (std::is_signed<_Type>::value && (sizeof(_Type) == 4 || sizeof(_Type) == 8)),
+			"parallel_hybrid_inplace_msd_radix_sort: only 64-bit unsigned, 32/64-bit signed integer and float/double keys are supported by this overload");
+		typedef RadixKeyTransform< _Type > _KeyTransform;
+		typedef typename _KeyTransform::UnsignedType _UnsignedType;
+		if (a_size < 2)	return;
+
+		const long PowerOfTwoRadix = 256;
+		const long Log2ofPowerOfTwoRadix = 8;
+		const long Threshold = 100;
+
+		unsigned long shiftRightAmount = sizeof(_UnsignedType) * 8 - Log2ofPowerOfTwoRadix;
+		_UnsignedType bitMask = (_UnsignedType)((_UnsignedType)(PowerOfTwoRadix - 1) << shiftRightAmount);	// top digit
+
+		if (a_size >= Threshold)
+			_RadixSort_Unsigned_PowerOf2Radix_Par_L1< _UnsignedType, PowerOfTwoRadix, Log2ofPowerOfTwoRadix, Threshold, _KeyTransform, true >((_UnsignedType*)a, a_size, bitMask, shiftRightAmount);
+		else
+			insertionSortSimilarToSTLnoSelfAssignment(a, a_size);
+	}
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+// Reusable working memory for Radix Sorts
+
+#ifndef _RadixSortWorkspace_h
+#define _RadixSortWorkspace_h
+
+#include "NumaTaskArenas.h"
+#include "LargePageAllocator.h"
+
+#include <stddef.h>
+#include <new>
+
+namespace ParallelAlgorithms
+{
+	// Owns all of the working memory of the parallel LSD Radix Sort (including its key-value and record versions): the temporary/working buffers, the flattened count and start-of-bin tables,
+	// and the cache-line aligned de-randomization bin buffers. Each of these grows on demand and is kept for the next sort, which eliminates
+	// allocations and page faults of freshly allocated memory from every call, when sorting many arrays.
+	// Not thread-safe: use a separate workspace for each sort that runs concurrently.
+	class RadixSortWorkspace
+	{
+	public:
+		RadixSortWorkspace() {}
+		~RadixSortWorkspace() { release(); }
+
+		RadixSortWorkspace(const RadixSortWorkspace&) = delete;
+		RadixSortWorkspace& operator=(const RadixSortWorkspace&) = delete;
+
+		// Temporary/working buffer of at least "size" elements, backed by large pages (see LargePageAllocator.h). Contents are not preserved when the buffer grows.
+		// In NUMA mode, a newly allocated buffer is first-touched by the node owning each slice of its "size" elements.
+		template< class _Type >
+		_Type* work_buffer(size_t size)
+		{
+			bool grows = size * sizeof(_Type) > m_work.bytes;
+			_Type* buffer = static_cast<_Type*>(reserve(m_work, size * sizeof(_Type), true));
+			if (grows && m_numaArenas != NULL)
+				m_numaArenas->first_touch(buffer, size * sizeof(_Type));
+			return buffer;
+		}
+
+		// Second temporary/working buffer of at least "size" elements, for the values of the key-value (sort by key) Radix Sort, whose keys use work_buffer()
+		template< class _Type >
+		_Type* value_work_buffer(size_t size)
+		{
+			bool grows = size * sizeof(_Type) > m_valueWork.bytes;
+			_Type* buffer = static_cast<_Type*>(reserve(m_valueWork, size * sizeof(_Type), true));
+			if (grows && m_numaArenas != NULL)
+				m_numaArenas->first_touch(buffer, size * sizeof(_Type));
+			return buffer;
+		}
+
+		// Tables of count[quanta][NumberOfBins] and startOfBin[quanta][NumberOfBins], with each row starting on its own cache line of a single flat arena.
+		// Counts of a work quanta never exceed its size, and can be held in 32-bit counters (_CountType of uint32_t) for work quanta of fewer than 2^32 elements,
+		// which halves the cache footprint of the count tables. Start of bin indexes span the whole array, and stay size_t.
+		template< class _CountType = size_t >
+		_CountType** count_table(   size_t numberOfQuantas, size_t numberOfBins) { return rows< _CountType >(m_countRows,       m_count,       numberOfQuantas, numberOfBins * sizeof(_CountType)); }
+		size_t** start_of_bin_table(size_t numberOfQuantas, size_t numberOfBins) { return rows< size_t     >(m_startOfBinRows,  m_startOfBin,  numberOfQuantas, numberOfBins * sizeof(size_t)); }
+		size_t** buffer_index_table(size_t numberOfQuantas, size_t numberOfBins) { return rows< size_t     >(m_bufferIndexRows, m_bufferIndex, numberOfQuantas, numberOfBins * sizeof(size_t)); }
+
+		// Private histograms of the next digit for each permutation task: nextCount[quanta][numberOfCounts], used when the next histogram is fused into the permutation
+		template< class _CountType = size_t >
+		_CountType** next_count_table(size_t numberOfQuantas, size_t numberOfCounts) { return rows< _CountType >(m_nextCountRows, m_nextCount, numberOfQuantas, numberOfCounts * sizeof(_CountType)); }
+
+		size_t* buffer_index_end(size_t numberOfBins)
+		{
+			return static_cast<size_t*>(reserve(m_bufferIndexEnd, numberOfBins * sizeof(size_t)));
+		}
+
+		// De-randomization buffers of BufferDepth elements for each bin, for each work quanta: bufferDerandomize[quanta][NumberOfBins * BufferDepth]
+		template< class _Type >
+		_Type** bin_buffers(size_t numberOfQuantas, size_t numberOfBins, size_t bufferDepth)
+		{
+			return rows< _Type >(m_binsRows, m_bins, numberOfQuantas, numberOfBins * bufferDepth * sizeof(_Type));
+		}
+
+		// De-randomization buffers of the values of the key-value Radix Sort, which share buffer indexes with the key buffers of bin_buffers()
+		template< class _Type >
+		_Type** value_bin_buffers(size_t numberOfQuantas, size_t numberOfBins, size_t bufferDepth)
+		{
+			return rows< _Type >(m_valueBinsRows, m_valueBins, numberOfQuantas, numberOfBins * bufferDepth * sizeof(_Type));
+		}
+
+		// Flush de-randomization buffers with non-temporal (streaming) stores, which bypass the cache instead of evicting useful cache lines.
+		// Beneficial when the array is much larger than the last level cache. Off by default.
+		void streaming_stores(bool enable) { m_streamingStores = enable; }
+		bool streaming_stores() const      { return m_streamingStores; }
+
+		// NUMA mode: run the work quanta of each node's slice of the array on that node, with the working buffer first-touched by the same nodes.
+		// Off (NULL) by default. Set before the first sort, as a buffer keeps the placement of its first touch. The arenas are not owned by the workspace.
+		void numa_arenas(NumaTaskArenas* numaArenas) { m_numaArenas = numaArenas; }
+		NumaTaskArenas* numa_arenas() const          { return m_numaArenas; }
+
+		// Total bytes of working memory currently held
+		size_t capacity_in_bytes() const
+		{
+			return m_work.bytes + m_valueWork.bytes + m_count.bytes + m_countRows.bytes + m_startOfBin.bytes + m_startOfBinRows.bytes + m_bufferIndex.bytes + m_bufferIndexRows.bytes +
+				   m_nextCount.bytes + m_nextCountRows.bytes + m_bufferIndexEnd.bytes + m_bins.bytes + m_binsRows.bytes + m_valueBins.bytes + m_valueBinsRows.bytes;
+		}
+
+		// Frees all of the working memory, which will be allocated again by the next sort using this workspace
+		void release()
+		{
+			deallocate(m_work);        deallocate(m_valueWork);
+			deallocate(m_count);       deallocate(m_countRows);
+			deallocate(m_startOfBin);  deallocate(m_startOfBinRows);
+			deallocate(m_bufferIndex); deallocate(m_bufferIndexRows);
+			deallocate(m_nextCount);   deallocate(m_nextCountRows);
+			deallocate(m_bufferIndexEnd);
+			deallocate(m_bins);        deallocate(m_binsRows);
+			deallocate(m_valueBins);   deallocate(m_valueBinsRows);
+		}
+
+	private:
+		static const size_t CacheLineSize = 64;
+
+		struct Block
+		{
+			void*  ptr        = NULL;
+			size_t bytes      = 0;
+			bool   largePages = false;
+		};
+
+		static void* reserve(Block& block, size_t bytes, bool largePages = false)
+		{
+			if (bytes > block.bytes)
+			{
+				deallocate(block);
+				if (largePages)
+				{
+					block.ptr = allocate_large_page_bytes(bytes);
+					if (block.ptr == NULL)
+						throw std::bad_alloc();
+				}
+				else
+					block.ptr = operator new[](bytes, (std::align_val_t)(CacheLineSize));
+				block.bytes      = bytes;
+				block.largePages = largePages;
+			}
+			return block.ptr;
+		}
+
+		static void deallocate(Block& block)
+		{
+			if (block.ptr != NULL && block.largePages)
+				free_large_page_bytes(block.ptr, block.bytes);
+			else if (block.ptr != NULL)
+				::operator delete[](block.ptr, std::align_val_t{ CacheLineSize });
+			block.ptr   = NULL;
+			block.bytes = 0;
+		}
+
+		// Array of row pointers into a single flat allocation, with each row padded to a multiple of the cache line
+		template< class _Type >
+		static _Type** rows(Block& rowsBlock, Block& dataBlock, size_t numberOfRows, size_t rowBytes)
+		{
+			rowBytes = (rowBytes + CacheLineSize - 1) / CacheLineSize * CacheLineSize;
+			char*   data   = static_cast<char*>(reserve(dataBlock, numberOfRows * rowBytes));
+			_Type** rowPtr = static_cast<_Type**>(reserve(rowsBlock, numberOfRows * sizeof(_Type*)));
+			for (size_t r = 0; r < numberOfRows; r++)
+				rowPtr[r] = reinterpret_cast<_Type*>(data + r * rowBytes);
+			return rowPtr;
+		}
+
+		Block m_work,        m_valueWork;
+		Block m_count,       m_countRows;
+		Block m_startOfBin,  m_startOfBinRows;
+		Block m_bufferIndex, m_bufferIndexRows;
+		Block m_nextCount,   m_nextCountRows;
+		Block m_bufferIndexEnd;
+		Block m_bins,        m_binsRows;
+		Block m_valueBins,   m_valueBinsRows;
+		bool  m_streamingStores = false;
+		NumaTaskArenas* m_numaArenas = NULL;
+	};
+}
+
+#endif
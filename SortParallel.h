@@ -14,6 +14,7 @@
 #include <execution>
 
 #include "ParallelMergeSort.h"
+#include "LargePageAllocator.h"
 
 namespace ParallelAlgorithms
 {
@@ -37,7 +38,7 @@ namespace ParallelAlgorithms
     inline void sort_par(_Type* src, size_t l, size_t r)
     {
         size_t src_size = r;
-        _Type* sorted = new(std::nothrow) _Type[src_size];
+        _Type* sorted = allocate_working_buffer< _Type >(src_size, std::nothrow);
 
         if (!sorted)
             sort(std::execution::par_unseq, src + l, src + r);
@@ -45,7 +46,7 @@ namespace ParallelAlgorithms
         {
             ParallelAlgorithms::parallel_merge_sort_hybrid_rh_1(src, l, r - 1, sorted, false);    // r - 1 because this algorithm wants inclusive bounds
 
-            delete[] sorted;
+            free_working_buffer(sorted, src_size);
         }
     }
 